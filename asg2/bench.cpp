@@ -0,0 +1,158 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// ydcbench -
+//    Microbenchmarks for bigint.  Each operation is timed on
+//    operands of 10, 100, ... up to -m digits (default 10^7), repeated
+//    until it has run for -t seconds (default 0.2), at least once.
+//    Results go to stdout as one JSON object per line:
+//       {"op": "mul", "digits": 1000, "iterations": 52011,
+//        "ns_per_op": 3845.1, "digits_per_sec": 2.6e+08}
+//    so runs from two releases can be compared line by line.
+//    Operands come from a fixed seed, so every run sees the same
+//    numbers.  Options:
+//    -j threads  multiply with up to this many threads
+//    -m digits   largest operand size
+//    -t seconds  minimum time per measurement
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+using namespace std;
+
+#include <unistd.h>
+
+#include "bigint.h"
+#include "util.h"
+
+using steady = chrono::steady_clock;
+
+static size_t max_digits = 10000000;
+static double min_seconds = 0.2;
+
+//
+// Operation results land here so the optimizer can not drop them.
+//
+static volatile bool sink;
+
+static string random_digits (mt19937_64& random, size_t digits) {
+   uniform_int_distribution<int> digit ('0', '9');
+   string text (digits, '0');
+   for (char& ch: text) ch = digit (random);
+   text[0] = '1' + random() % 9;
+   return text;
+}
+
+static void measure (const string& name, size_t digits,
+                     const function<void()>& operation) {
+   size_t iterations = 0;
+   steady::duration elapsed {0};
+   steady::time_point start = steady::now();
+   do {
+      operation();
+      ++iterations;
+      elapsed = steady::now() - start;
+   }while (chrono::duration<double> (elapsed).count() < min_seconds);
+   double ns_per_op = chrono::duration<double, nano> (elapsed).count()
+                    / iterations;
+   cout << "{\"op\": \"" << name << "\", \"digits\": " << digits
+        << ", \"iterations\": " << iterations
+        << ", \"ns_per_op\": " << ns_per_op
+        << ", \"digits_per_sec\": " << digits * 1e9 / ns_per_op
+        << "}" << endl;
+}
+
+//
+// Every operation at one size.  The operands have the given number
+// of digits, except the dividends, which have twice that, and pow,
+// which raises 3 to a power with about that many digits.  Division
+// alternates between two dividends, since bigint remembers the last
+// quotient it computed.
+//
+static void bench_size (mt19937_64& random, size_t digits) {
+   const string text = random_digits (random, digits);
+   const bigint left (text);
+   const bigint right (random_digits (random, digits));
+   const bigint dividends[] {
+      bigint (random_digits (random, 2 * digits)),
+      bigint (random_digits (random, 2 * digits)),
+   };
+   size_t turn = 0;
+   const bigint three (3);
+   const bigint exponent (long (digits / 0.47712125472));
+   measure ("add", digits, [&]() {
+      sink = (left + right).is_zero();
+   });
+   measure ("sub", digits, [&]() {
+      sink = (left - right).is_zero();
+   });
+   measure ("mul", digits, [&]() {
+      sink = (left * right).is_zero();
+   });
+   measure ("div", digits, [&]() {
+      sink = (dividends[turn ^= 1] / right).is_zero();
+   });
+   measure ("pow", digits, [&]() {
+      sink = pow (three, exponent).is_zero();
+   });
+   measure ("print", digits, [&]() {
+      ostringstream out;
+      out << left;
+      sink = out.tellp() == 0;
+   });
+   measure ("parse", digits, [&]() {
+      sink = bigint (text).is_zero();
+   });
+}
+
+static bool parse_number (const char* text, double& number) {
+   char* end = nullptr;
+   number = strtod (text, &end);
+   return *text != '\0' and *end == '\0' and number > 0;
+}
+
+void scan_options (int argc, char** argv) {
+   opterr = 0;
+   for (;;) {
+      int option = getopt (argc, argv, "j:m:t:");
+      if (option == EOF) break;
+      double number = 0;
+      bool valid = parse_number (optarg ? optarg : "", number);
+      switch (option) {
+         case 'j':
+            if (valid) bigtuning::threads = number;
+            break;
+         case 'm':
+            if (valid) max_digits = number;
+            break;
+         case 't':
+            if (valid) min_seconds = number;
+            break;
+         default:
+            complain() << "-" << (char) optopt << ": invalid option"
+                       << endl;
+            continue;
+      }
+      if (not valid) {
+         complain() << "-" << (char) option << " " << optarg
+                    << ": invalid number" << endl;
+      }
+   }
+}
+
+int main (int argc, char** argv) {
+   sys_info::execname (argv[0]);
+   scan_options (argc, argv);
+   if (sys_info::status() != EXIT_SUCCESS) return sys_info::status();
+   mt19937_64 random (20141009);
+   for (size_t digits = 10; digits <= max_digits; digits *= 10) {
+      bench_size (random, digits);
+   }
+   return sys_info::status();
+}
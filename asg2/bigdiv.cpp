@@ -0,0 +1,208 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// Long division of limb magnitudes.  Knuth's Algorithm D (TAOCP
+// vol 2, 4.3.1) in base 10^9 handles short divisors and is the base
+// case of Burnikel and Ziegler's recursive division ("Fast Recursive
+// Division", MPI-I-98-1-022), which takes over once both divisor
+// and quotient reach bz_threshold limbs.  The recursion does its
+// work in limbs_mul, so large divisions scale like multiplication.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#include "limbs.h"
+
+using sdlimb_t = int64_t;
+
+//
+// u[0..bn] -= qhat * v[0..bn).  Returns true if the result went
+// negative, in which case qhat was one too large.
+//
+static bool mul_sub (limb_t* u, const limb_t* v, size_t bn,
+                     dlimb_t qhat) {
+   dlimb_t carry = 0;
+   sdlimb_t borrow = 0;
+   for (size_t i = 0; i < bn; ++i) {
+      dlimb_t product = qhat * v[i] + carry;
+      carry = product / limb_radix;
+      sdlimb_t digit = sdlimb_t (u[i]) - sdlimb_t (product % limb_radix)
+                     - borrow;
+      borrow = digit < 0;
+      u[i] = borrow ? digit + limb_radix : digit;
+   }
+   sdlimb_t top = sdlimb_t (u[bn]) - sdlimb_t (carry) - borrow;
+   u[bn] = top < 0 ? top + limb_radix : top;
+   return top < 0;
+}
+
+static void divrem_knuth (limb_t* q, limb_t* r,
+                          const limb_t* a, size_t an,
+                          const limb_t* b, size_t bn) {
+   if (bn == 1) {
+      r[0] = limbs_divrem_1 (q, a, an, b[0]);
+      return;
+   }
+
+   //
+   // Normalize so the top limb of the divisor is at least radix / 2,
+   // which keeps each trial quotient within two of the truth.
+   //
+   limb_t scale = limb_radix / (dlimb_t (b[bn - 1]) + 1);
+   limb_scratch u (an + 1);
+   limb_scratch v (bn);
+   u[an] = limbs_mul_1 (u.data(), a, an, scale);
+   limbs_mul_1 (v.data(), b, bn, scale);
+   dlimb_t vtop = v[bn - 1];
+   dlimb_t vnext = v[bn - 2];
+
+   for (size_t j = an - bn + 1; j-- > 0; ) {
+      limb_t* uj = u.data() + j;
+      dlimb_t numerator = dlimb_t (uj[bn]) * limb_radix + uj[bn - 1];
+      dlimb_t qhat = numerator / vtop;
+      dlimb_t rhat = numerator % vtop;
+      while (qhat >= limb_radix
+             or qhat * vnext > rhat * limb_radix + uj[bn - 2]) {
+         --qhat;
+         rhat += vtop;
+         if (rhat >= limb_radix) break;
+      }
+      if (mul_sub (uj, v.data(), bn, qhat)) {
+         --qhat;
+         uj[bn] += limbs_add (uj, uj, bn, v.data(), bn);
+         uj[bn] -= limb_radix;
+      }
+      q[j] = qhat;
+   }
+   limbs_divrem_1 (r, u.data(), bn, scale);
+}
+
+static void div_3n2n (limb_t* q, limb_t* r, const limb_t* a,
+                      const limb_t* b, size_t k);
+
+//
+// q[0..n) = a / b and r[0..n) = a % b, where a has 2n limbs, b has
+// n limbs with its top limb at least radix / 2, and a < b radix^n.
+//
+static void div_2n1n (limb_t* q, limb_t* r, const limb_t* a,
+                      const limb_t* b, size_t n) {
+   if (n % 2 != 0 or n < bigtuning::bz_threshold) {
+      limb_scratch quotient (n + 1);
+      divrem_knuth (quotient.data(), r, a, 2 * n, b, n);
+      memcpy (q, quotient.data(), n * sizeof *q);
+      return;
+   }
+   size_t k = n / 2;
+   limb_scratch upper (n);
+   div_3n2n (q + k, upper.data(), a + k, b, k);
+   limb_scratch lower (3 * k);
+   memcpy (lower.data(), a, k * sizeof *a);
+   memcpy (lower.data() + k, upper.data(), n * sizeof *a);
+   div_3n2n (q, r, lower.data(), b, k);
+}
+
+//
+// q[0..k) = a / b and r[0..2k) = a % b, where a has 3k limbs, b has
+// 2k limbs with its top limb at least radix / 2, and a < b radix^k.
+//
+static void div_3n2n (limb_t* q, limb_t* r, const limb_t* a,
+                      const limb_t* b, size_t k) {
+   const limb_t* a1 = a + 2 * k;
+   const limb_t* b1 = b + k;
+
+   //
+   // Estimate the quotient from the top two thirds of a and the top
+   // half of b.  The estimate is at most two too large.
+   //
+   limb_scratch rhat (2 * k + 1);
+   if (limbs_cmp (a1, k, b1, k) < 0) {
+      div_2n1n (q, rhat.data() + k, a + k, b1, k);
+   }else {
+      fill (q, q + k, limb_radix - 1);
+      rhat[2 * k] = limbs_add (rhat.data() + k, a + k, k, b1, k);
+   }
+   memcpy (rhat.data(), a, k * sizeof *a);
+
+   limb_scratch product (2 * k);
+   limbs_mul (product.data(), q, k, b, k);
+   if (limbs_cmp (rhat.data(), rhat.size(), product.data(),
+                  product.size()) >= 0) {
+      limbs_sub (rhat.data(), rhat.data(), rhat.size(),
+                 product.data(), product.size());
+      memcpy (r, rhat.data(), 2 * k * sizeof *r);
+      return;
+   }
+   const limb_t one = 1;
+   limb_scratch deficit (2 * k + 1);
+   limbs_sub (deficit.data(), product.data(), product.size(),
+              rhat.data(), 2 * k);
+   deficit[2 * k] = 0;
+   for (;;) {
+      limbs_sub (q, q, k, &one, 1);
+      if (limbs_cmp (deficit.data(), deficit.size(), b, 2 * k) <= 0) {
+         limbs_sub (r, b, 2 * k, deficit.data(), 2 * k);
+         return;
+      }
+      limbs_sub (deficit.data(), deficit.data(), deficit.size(),
+                 b, 2 * k);
+   }
+}
+
+//
+// Pad the divisor to n = j 2^m limbs, with j below the threshold, so
+// that halving always ends on an even split, and scale both operands
+// so the divisor's top limb is at least radix / 2.  m stops growing
+// once j is down to one limb, so the loop ends for any threshold.
+// The dividend is then divided n limbs at a time, high blocks first.
+//
+static void divrem_bz (limb_t* q, limb_t* r, const limb_t* a, size_t an,
+                       const limb_t* b, size_t bn) {
+   size_t blocks = 1;
+   while (blocks < bn
+          and (bn + blocks - 1) / blocks >= bigtuning::bz_threshold) {
+      blocks *= 2;
+   }
+   size_t n = (bn + blocks - 1) / blocks * blocks;
+   size_t shift = n - bn;
+   limb_t scale = limb_radix / (dlimb_t (b[bn - 1]) + 1);
+
+   limb_scratch divisor (n);
+   limbs_mul_1 (divisor.data() + shift, b, bn, scale);
+   size_t dividendn = an + 1 + shift;
+   size_t t = max<size_t> (2, (dividendn + n) / n);
+   limb_scratch dividend (t * n);
+   dividend[shift + an] = limbs_mul_1 (dividend.data() + shift,
+                                       a, an, scale);
+
+   limb_scratch quotient ((t - 1) * n);
+   limb_scratch z (2 * n);
+   limb_scratch remainder (n);
+   memcpy (z.data(), dividend.data() + (t - 2) * n,
+           2 * n * sizeof *a);
+   for (size_t i = t - 1; i-- > 0; ) {
+      div_2n1n (quotient.data() + i * n, remainder.data(), z.data(),
+                divisor.data(), n);
+      if (i == 0) break;
+      memcpy (z.data(), dividend.data() + (i - 1) * n, n * sizeof *a);
+      memcpy (z.data() + n, remainder.data(), n * sizeof *a);
+   }
+   size_t qn = an - bn + 1;
+   memset (q, 0, qn * sizeof *q);
+   memcpy (q, quotient.data(), min (qn, quotient.size()) * sizeof *q);
+   limbs_divrem_1 (r, remainder.data() + shift, bn, scale);
+}
+
+void limbs_divrem (limb_t* q, limb_t* r, const limb_t* a, size_t an,
+                   const limb_t* b, size_t bn) {
+   if (bn >= bigtuning::bz_threshold
+       and an - bn >= bigtuning::bz_threshold) {
+      divrem_bz (q, r, a, an, b, bn);
+   }else {
+      divrem_knuth (q, r, a, an, b, bn);
+   }
+}
+
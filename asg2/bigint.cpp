@@ -1,9 +1,14 @@
 //Brandon Jarvinen (bjarvine@ucsc.edu)
 //Fan Zhang (fzhang12@ucsc.edu)
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <stack>
 #include <stdexcept>
 using namespace std;
@@ -11,328 +16,859 @@ using namespace std;
 #include "bigint.h"
 #include "debug.h"
 
-bigint::bigint (long that): long_value (that) { //constructor
-   DEBUGF ('~', this << " -> " << long_value)
+using digit_t = bigint::digit_t;
+using bigvalue_t = bigint::bigvalue_t;
+using limb_span = bigint::limb_span;
+using wide_t = unsigned __int128;
+
+static const wide_t small_max = numeric_limits<uint64_t>::max();
+
+static void trim_zero (bigvalue_t& value) {
+   while (not value.empty() and value.back() == 0) value.pop_back();
 }
 
-bigint::bigint (const string& that) {//constructor
-   this->negative = false;
-   auto itor = that.cbegin();
-   if (itor != that.cend() and *itor == '_') {
-      this->negative = true;
-      ++itor;
-   }
-   bigvalue.clear();
-  
-   for(auto i = that.crbegin(); i != that.crend(); i++){
-      if(*i == '_') {
-         continue;
+bigint::limb_span::limb_span (const bigint& that) {
+   that.settle();
+   if (that.is_small()) {
+      uint64_t magnitude = that.small;
+      for (count = 0; magnitude > 0; magnitude /= radix) {
+         local[count++] = magnitude % radix;
       }
-      bigvalue.push_back(*i - '0');
+      limbs = local;
+   }else {
+      limbs = that.limbs().data();
+      count = that.limbs().size();
    }
-   DEBUGF ('~', this << " -> " << long_value)
 }
 
-bigint::bigint (bigvalue_t value, bool neg) {
-   this->negative = neg;
-   this->bigvalue = value;
-}
-
-bigint do_add (const bigint& left, const bigint& right) { //fin
-   bigint::digit_t carry = 0;
-   bigint::digit_t digit = 0;
-   bool neg;
-   bigint::bigvalue_t result;
-   
-   auto i = left.bigvalue.cbegin();
-   auto j = right.bigvalue.cbegin();
-   
-   for(;;) {
-      if(i == left.bigvalue.cend() && j == right.bigvalue.cend()) {
-         if(carry) {
-            result.push_back(carry);
-         }
-         break;
-      }
-      if(i != left.bigvalue.cend()){;
-         digit += *i;
-         ++i;
-      }
-      if(j != right.bigvalue.cend()){
-         digit += *j;
-         ++j;
-      }
-      
-      digit += carry;
-      result.push_back((digit % 10));
-      carry = digit / 10;
-      digit = 0;
-   }
-   
-   if(left.negative) neg = true;
-   else neg = false;
-   
-   bigint final = bigint(result, neg);
-   return final;
-}
-
-bigint do_sub(bigint left, bigint right) { //left > right guaranteed
-   bigint::digit_t borrow = 0;
-   bigint::digit_t digit_l = 0; // current left digit
-   bigint::digit_t digit_r = 0; // current right digit
-   bigint::digit_t digit = 0;
-   bigint::bigvalue_t result;
-   
-   auto i = left.bigvalue.cbegin();
-   auto j = right.bigvalue.cbegin();
-   
-   for(;;) {
-      if(i == left.bigvalue.cend() && j == right.bigvalue.cend()) {
-         break;
+//
+// The limbs, for writing, copied first if another bigint shares
+// them.  A small value gets an empty vector to fill in.
+//
+bigvalue_t& bigint::own_limbs() {
+   if (bigvalue == nullptr) {
+      bigvalue = make_shared<bigvalue_t>();
+   }else if (bigvalue.use_count() > 1) {
+      bigvalue = make_shared<bigvalue_t> (*bigvalue);
+   }
+   return *bigvalue;
+}
+
+//
+// Restore the invariants after bigvalue has been filled in:  trim
+// it, and move it back into small if it fits.
+//
+void bigint::normalize() {
+   if (is_small()) {
+      if (small == 0) negative = false;
+      return;
+   }
+   bigvalue_t& value = own_limbs();
+   trim_zero (value);
+   if (value.size() <= 3) {
+      wide_t magnitude = 0;
+      for (size_t i = value.size(); i-- > 0; ) {
+         magnitude = magnitude * radix + value[i];
       }
-      if(i != left.bigvalue.cend()){
-         digit_l = *i;
+      if (magnitude <= small_max) {
+         small = magnitude;
+         bigvalue = nullptr;
       }
-      if(j != right.bigvalue.cend()){
-         digit_r = *j;
+   }
+   if (is_zero()) negative = false;
+}
+
+bigint bigint::from_wide (wide_t magnitude, bool neg) {
+   bigint result;
+   if (magnitude <= small_max) {
+      result.small = magnitude;
+   }else {
+      bigvalue_t& value = result.own_limbs();
+      for (; magnitude > 0; magnitude /= radix) {
+         value.push_back (magnitude % radix);
       }
-      
-      if(i != left.bigvalue.cend() && j != right.bigvalue.cend()){
-         digit = digit_l - digit_r - borrow + 10;
-         ++i;
-         ++j;
+   }
+   result.negative = neg and not result.is_zero();
+   return result;
+}
+
+bigint::bigint (long that) { //constructor
+   negative = that < 0;
+   small = negative ? 0UL - that : that;
+   DEBUGF ('~', this << " -> " << *this)
+}
+
+bigint::bigint (const string& that): bigint (that.data(), that.size()) {
+}
+
+//
+// Parse a decimal literal, with an optional leading '_', straight
+// into small or into limbs, radix_digits characters per limb.
+//
+bigint::bigint (const char* text, size_t length) {
+   size_t first = 0;
+   if (first < length and text[first] == '_') {
+      negative = true;
+      ++first;
+   }
+   while (first < length and text[first] == '0') ++first;
+   if (length - first < numeric_limits<uint64_t>::digits10) {
+      for (size_t i = first; i < length; ++i) {
+         small = small * 10 + text[i] - '0';
       }
-      else if(i != left.bigvalue.cend() && j == right.bigvalue.cend()){
-         digit = digit_l - 0 - borrow + 10;
-         ++i;
+   }else {
+      bigvalue_t& value = own_limbs();
+      value.reserve ((length - first) / radix_digits + 1);
+      // Peel off radix_digits characters at a time from the low end.
+      for (size_t end = length; end > first; ) {
+         size_t begin = end - first > radix_digits ? end - radix_digits
+                                                   : first;
+         digit_t limb = 0;
+         for (size_t i = begin; i < end; ++i) {
+            limb = limb * 10 + text[i] - '0';
+         }
+         value.push_back (limb);
+         end = begin;
       }
-      borrow = 1 - digit / 10;
-      result.push_back((digit % 10));
-      digit = 0;
    }
-   
-   return bigint(result, false);
+   normalize();
+   DEBUGF ('~', this << " -> " << *this)
 }
 
-//if LEFT -1, if RIGHT 1, else 0
-static int do_compare(bigint left, bigint right) { 
-   if(right.bigvalue.size() < left.bigvalue.size()) return -1;
-   if(left.bigvalue.size() < right.bigvalue.size()) return 1;
-   for(size_t i = 0; i < left.bigvalue.size(); i++) {
-      if(right.bigvalue.at(i) < left.bigvalue.at(i)) return -1;
-      if(left.bigvalue.at(i) < right.bigvalue.at(i)) return 1;
+bigint::bigint (bigvalue_t value, bool neg) {
+   this->bigvalue = make_shared<bigvalue_t> (move (value));
+   this->negative = neg;
+   normalize();
+}
+
+//
+// The text of a deferred literal, shared by its copies, and its
+// value once one of them has settled.  call_once lets copies on two
+// threads settle at the same time.
+//
+struct bigint::pending {
+   string text;
+   once_flag parsed;
+   bigint value;
+};
+
+//
+// A literal with no more digits than small can hold is parsed at
+// once, since that is cheaper than allocating its text.
+//
+bigint bigint::deferred (const char* text, size_t length) {
+   size_t first = length > 0 and text[0] == '_' ? 1 : 0;
+   while (first < length and text[first] == '0') ++first;
+   if (length - first <= numeric_limits<uint64_t>::digits10 + 1) {
+      return bigint (text, length);
    }
-   return 0;
+   bigint result;
+   result.decimal = make_shared<pending>();
+   result.decimal->text.assign (text, length);
+   return result;
 }
 
-bigint trim_zero (bigint& that){
-   for(auto i = that.bigvalue.crbegin(); *i == 0; i++){
-      that.bigvalue.pop_back();
+//
+// The last copy to settle takes the limbs rather than sharing them,
+// so that it can change them without copying.
+//
+void bigint::parse_decimal() const {
+   pending& literal = *decimal;
+   call_once (literal.parsed, [&literal]() {
+      literal.value = bigint (literal.text.data(), literal.text.size());
+   });
+   small = literal.value.small;
+   negative = literal.value.negative;
+   if (decimal.use_count() == 1) {
+      bigvalue = move (literal.value.bigvalue);
+   }else {
+      bigvalue = literal.value.bigvalue;
    }
-   return that;
+   decimal = nullptr;
 }
 
-bigint operator+ (const bigint& left, const bigint& right) { //fin
-   bigint result;
-   if(!left.negative && !right.negative){
-      result = do_add(left, right);
-   }
-   else if(left.negative && right.negative) {
-      result = do_add(left, right);
-      result.negative = true;
-   }
-   else if(left.negative && !right.negative) {
-      int cmp = do_compare(left, right);
-      if(cmp == 0) {
-         result = do_sub(left, right);
-      } else if(cmp < 0) {
-         result = do_sub(left, right);
-         result.negative = true;
-      } else {
-         result = do_sub(right, left);
-      }         
-   } else if(!left.negative && right.negative) {
-      int cmp = do_compare(left, right);
-      if(cmp == 0) {
-         result = do_sub(left, right);
-      } else if(cmp < 0) {
-         result = do_sub(left, right);
-      } else {
-         result = do_sub(right, left);
-         result.negative = true;
-      }    
-   }
-   
+//
+// Magnitude helpers.  These ignore signs entirely.
+//
+
+static bigvalue_t do_add (const limb_span& left,
+                          const limb_span& right) {
+   bool swapped = left.size() < right.size();
+   const limb_span& longer = swapped ? right : left;
+   const limb_span& shorter = swapped ? left : right;
+   bigvalue_t result (longer.size() + 1);
+   result.back() = limbs_add (result.data(), longer.data(),
+                        longer.size(), shorter.data(), shorter.size());
    return result;
 }
 
-bigint operator- (const bigint& left, const bigint& right) {
-   bigint result;
-   if(left.negative && !right.negative) {
-      result = do_add(left, right);
-      result.negative = true;
-   } else if (!left.negative && right.negative) {
-      result = do_add(left, right);
-   } else {
-      int cmp = do_compare(left, right);
-      if(cmp == 0) {
-         result = do_sub(left, right);
-      } else if (cmp < 0) {
-         result = do_sub(left, right);
-      } else {
-         result = do_sub(right, left);
-         result.negative = true;
+static bigvalue_t do_sub (const limb_span& left,
+                          const limb_span& right) { //left >= right
+   bigvalue_t result (left.size());
+   limbs_sub (result.data(), left.data(), left.size(),
+              right.data(), right.size());
+   return result;
+}
+
+//if LEFT is smaller -1, if RIGHT is smaller 1, else 0
+int do_compare (const bigint& left, const bigint& right) {
+   left.settle();
+   right.settle();
+   if (left.is_small() and right.is_small()) {
+      return left.small < right.small ? -1 : left.small > right.small;
+   }
+   if (left.is_small() != right.is_small()) {
+      return left.is_small() ? -1 : 1;
+   }
+   return limbs_cmp (left.limbs().data(), left.limbs().size(),
+                     right.limbs().data(), right.limbs().size());
+}
+
+//
+// Add left to right, treating right as negative if right_neg.
+// Subtraction is addition with the sign of right flipped.
+//
+bigint do_signed_add (const bigint& left, const bigint& right,
+                      bool right_neg) {
+   left.settle();
+   right.settle();
+   if (left.is_small() and right.is_small()) {
+      if (left.negative == right_neg) {
+         return bigint::from_wide (wide_t (left.small) + right.small,
+                                   left.negative);
       }
+      if (left.small >= right.small) {
+         return bigint::from_wide (left.small - right.small,
+                                   left.negative);
+      }
+      return bigint::from_wide (right.small - left.small, right_neg);
    }
-   
-   result = trim_zero(result);
-   return result;
+   limb_span lspan (left);
+   limb_span rspan (right);
+   if (left.negative == right_neg) {
+      return bigint (do_add (lspan, rspan), left.negative);
+   }
+   int cmp = do_compare (left, right);
+   if (cmp == 0) return bigint();
+   if (cmp > 0) return bigint (do_sub (lspan, rspan), left.negative);
+   return bigint (do_sub (rspan, lspan), right_neg);
+}
+
+bigint operator+ (const bigint& left, const bigint& right) {
+   right.settle();
+   return do_signed_add (left, right, right.negative);
+}
+
+bigint operator- (const bigint& left, const bigint& right) {
+   right.settle();
+   return do_signed_add (left, right, not right.negative);
 }
 
-bigint operator+ (const bigint& right) { 
+bigint operator+ (const bigint& right) {
    return right;
 }
 
-bigint operator- (const bigint& right) { 
-   return -right.long_value;
+bigint operator- (const bigint& right) {
+   right.settle();
+   bigint result = right;
+   result.negative = not right.negative and not right.is_zero();
+   return result;
+}
+
+//
+// this += right, with right treated as negative if right_neg.  A
+// result that stays in limbs reuses this bigint's vector, unless
+// another bigint shares it.
+//
+void bigint::add_in_place (const bigint& right, bool right_neg) {
+   settle();
+   if (is_small()) {
+      *this = do_signed_add (*this, right, right_neg);
+      return;
+   }
+   limb_span rspan (right);
+   bigvalue_t& value = own_limbs();
+   if (negative == right_neg) {
+      if (value.size() < rspan.size()) {
+         value.resize (rspan.size());
+      }
+      digit_t carry = limbs_add (value.data(), value.data(),
+                     value.size(), rspan.data(), rspan.size());
+      if (carry) value.push_back (carry);
+      return;
+   }
+   if (do_compare (*this, right) >= 0) {
+      limbs_sub (value.data(), value.data(), value.size(),
+                 rspan.data(), rspan.size());
+   }else {
+      size_t size = value.size();
+      value.resize (rspan.size());
+      limbs_sub (value.data(), rspan.data(), rspan.size(),
+                 value.data(), size);
+      negative = right_neg;
+   }
+   normalize();
+}
+
+bigint& bigint::operator+= (const bigint& right) {
+   right.settle();
+   add_in_place (right, right.negative);
+   return *this;
 }
 
-long bigint::to_long() const { 
-   if (*this <= bigint (numeric_limits<long>::min())
-    or *this > bigint (numeric_limits<long>::max()))
-               throw range_error ("bigint__to_long: out of range");
-   return long_value;
+bigint& bigint::operator-= (const bigint& right) {
+   right.settle();
+   add_in_place (right, not right.negative);
+   return *this;
 }
 
-bool abs_less (const long& left, const long& right) {
-   return left < right;
+bigint& bigint::operator*= (const bigint& right) {
+   *this = *this * right;
+   return *this;
+}
+
+bigint& bigint::operator/= (const bigint& right) {
+   *this = divide (*this, right).first;
+   return *this;
+}
+
+bigint& bigint::operator%= (const bigint& right) {
+   *this = divide (*this, right).second;
+   return *this;
+}
+
+long bigint::to_long() const {
+   settle();
+   wide_t limit = numeric_limits<long>::max();
+   if (not is_small() or small > limit + (negative ? 1 : 0))
+      throw range_error ("bigint__to_long: out of range");
+   return negative ? -static_cast<long> (small - 1) - 1
+                   : static_cast<long> (small);
+}
+
+//
+// Number of decimal digits in the magnitude, counting 0 as one.  A
+// deferred value is counted from its text, and stays unparsed.
+//
+size_t bigint::digits() const {
+   if (decimal != nullptr) {
+      const string& text = decimal->text;
+      size_t first = text.size() > 0 and text[0] == '_' ? 1 : 0;
+      first = text.find_first_not_of ('0', first);
+      return first == string::npos ? 1 : text.size() - first;
+   }
+   if (is_small()) {
+      size_t count = 1;
+      for (uint64_t top = small; top >= 10; top /= 10) ++count;
+      return count;
+   }
+   size_t count = (limbs().size() - 1) * radix_digits + 1;
+   digit_t top = limbs().back();
+   for (; top >= 10; top /= 10) ++count;
+   return count;
 }
 
 //
 // Multiplication algorithm.
 //
 
-bigint operator* (const bigint& left, const bigint& right) { 
-   bigint::bigvalue_t v(left.bigvalue.size() 
-                              + right.bigvalue.size(), 0); 
-   
-   for(size_t i = 0; i < left.bigvalue.size(); i++) {
-      bigint::digit_t carry = 0;
-      for(size_t j = 0; j < right.bigvalue.size(); j++) {
-         bigint::digit_t d = v.at(i+j) + ((left.bigvalue.at(i)) 
-                                    * (right.bigvalue.at(j))) + carry;
-         v.at(i+j) = (d % 10);
-         carry = (d / 10);
-      }
-      v.at(i+right.bigvalue.size()) = carry;
+bigint operator* (const bigint& left, const bigint& right) {
+   left.settle();
+   right.settle();
+   bool negative = left.negative != right.negative;
+   if (left.is_small() and right.is_small()) {
+      return bigint::from_wide (wide_t (left.small) * right.small,
+                                negative);
+   }
+   limb_span lspan (left);
+   limb_span rspan (right);
+   bigvalue_t v (lspan.size() + rspan.size());
+   limbs_mul (v.data(), lspan.data(), lspan.size(),
+              rspan.data(), rspan.size());
+   return bigint (move (v), negative);
+}
+
+
+//
+// Division algorithm.
+//
+
+//
+// Quotient truncates toward zero and the remainder takes the sign
+// of the dividend, as in dc.  The last result is remembered, since
+// scripts often ask for / and then % of the same pair.  It is kept
+// only until the next division, and not at all for a dividend over
+// divide_cache_limbs, so the cache never holds large values for
+// long, nor shares their limbs with the stack.
+//
+static const size_t divide_cache_limbs = size_t (1) << 16;
 
+static struct {
+   bigint left;
+   bigint right;
+   bigint::quot_rem result;
+   bool valid {false};
+} last_divide;
+
+bigint::quot_rem divide (const bigint& left, const bigint& right) {
+   left.settle();
+   if (right.is_zero()) throw domain_error ("divide by zero");
+   bool negative = left.negative != right.negative;
+   if (left.is_small() and right.is_small()) {
+      return {bigint::from_wide (left.small / right.small, negative),
+              bigint::from_wide (left.small % right.small,
+                                 left.negative)};
+   }
+   if (last_divide.valid and last_divide.left == left
+                         and last_divide.right == right) {
+      DEBUGF ('/', "reusing " << left << " / " << right);
+      bigint::quot_rem result = move (last_divide.result);
+      last_divide = {};
+      return result;
    }
-   bool isNeg = false;
-   if((!left.negative && right.negative) || 
-            (left.negative && !right.negative)) {
-      isNeg = true;   
+   last_divide = {};
+   bigint::quot_rem result;
+   if (do_compare (left, right) < 0) {
+      result = {bigint(), left};
+   }else {
+      limb_span lspan (left);
+      limb_span rspan (right);
+      bigvalue_t quotient (lspan.size() - rspan.size() + 1);
+      bigvalue_t remainder (rspan.size());
+      limbs_divrem (quotient.data(), remainder.data(),
+                    lspan.data(), lspan.size(),
+                    rspan.data(), rspan.size());
+      result = {bigint (move (quotient), negative),
+                bigint (move (remainder), left.negative)};
+   }
+   if (left.is_small() or left.limbs().size() <= divide_cache_limbs) {
+      last_divide.left = left;
+      last_divide.right = right;
+      last_divide.result = result;
+      last_divide.valid = true;
    }
-   
-   bigint result = bigint(v, isNeg);
-   result = trim_zero(result);
    return result;
 }
 
+bigint operator/ (const bigint& left, const bigint& right) {
+   return divide (left, right).first;
+}
 
+bigint operator% (const bigint& left, const bigint& right) {
+   return divide (left, right).second;
+}
+
+bool operator== (const bigint& left, const bigint& right) {
+   left.settle();
+   right.settle();
+   if (left.negative != right.negative) return false;
+   if (left.is_small() or right.is_small()) {
+      return left.is_small() and right.is_small()
+         and left.small == right.small;
+   }
+   return left.bigvalue == right.bigvalue
+       or left.limbs() == right.limbs();
+}
 
+bool operator< (const bigint& left, const bigint& right) {
+   left.settle();
+   right.settle();
+   if (left.negative != right.negative) return left.negative;
+   int cmp = do_compare (left, right);
+   return left.negative ? cmp > 0 : cmp < 0;
+}
 
 //
-// Division algorithm.
+// Limbs are already decimal, so printing is a linear pass:  each
+// limb below the top one becomes exactly radix_digits characters,
+// two at a time from a table of digit pairs, and the text goes out
+// through line_writer in large blocks rather than limb by limb.
 //
-
-void multiply_by_2 (bigint::unumber& unumber_value) { 
-   unumber_value *= 2;
+static const char* digit_pairs() {
+   static char pairs[200];
+   static bool filled = false;
+   if (not filled) {
+      for (int i = 0; i < 100; ++i) {
+         pairs[2 * i] = '0' + i / 10;
+         pairs[2 * i + 1] = '0' + i % 10;
+      }
+      filled = true;
+   }
+   return pairs;
 }
 
-void divide_by_2 (bigint::unumber& unumber_value) { 
-   unumber_value /= 2;
+static char* put_limb (char* text, digit_t limb, const char* pairs) {
+   for (int pos = bigint::radix_digits - 1; pos > 0; pos -= 2) {
+      const char* pair = pairs + 2 * (limb % 100);
+      text[pos - 1] = pair[0];
+      text[pos] = pair[1];
+      limb /= 100;
+   }
+   text[0] = '0' + limb;
+   return text + bigint::radix_digits;
 }
 
+//
+// Output in blocks.  With a width above 1, each width - 1 characters
+// are followed by a backslash and a newline, as dc breaks long
+// numbers, but the last line is left for the caller to end.
+//
+class line_writer {
+   private:
+      ostream& out;
+      size_t width;
+      size_t column {0};
+      size_t used {0};
+      char block[4096 * bigint::radix_digits];
+      void append (const char* chars, size_t count);
+   public:
+      line_writer (ostream& out, size_t width):
+                   out (out), width (width) {}
+      void put (const char* chars, size_t count);
+      void flush();
+};
+
+void line_writer::append (const char* chars, size_t count) {
+   if (used + count > sizeof block) flush();
+   if (count >= sizeof block) {
+      out.write (chars, count);
+      return;
+   }
+   memcpy (block + used, chars, count);
+   used += count;
+}
 
-bigint::quot_rem divide (const bigint& left, const bigint& right) {
-   if (right == 0) throw domain_error ("divide by 0");
-   using unumber = unsigned long;
-   static unumber zero = 0;
-   if (right == 0) throw domain_error ("bigint::divide");
-   unumber divisor = right.long_value;
-   unumber quotient = 0;
-   unumber remainder = left.long_value;
-   unumber power_of_2 = 1;
-   while (abs_less (divisor, remainder)) {
-      multiply_by_2 (divisor);
-      multiply_by_2 (power_of_2);
-   }
-   while (abs_less (zero, power_of_2)) {
-      if (not abs_less (remainder, divisor)) {
-         remainder = remainder - divisor;
-         quotient = quotient + power_of_2;
+void line_writer::put (const char* chars, size_t count) {
+   if (width < 2) {
+      append (chars, count);
+      return;
+   }
+   while (count > 0) {
+      if (column == width - 1) {
+         append ("\\\n", 2);
+         column = 0;
       }
-      divide_by_2 (divisor);
-      divide_by_2 (power_of_2);
+      size_t line = min (count, width - 1 - column);
+      append (chars, line);
+      column += line;
+      chars += line;
+      count -= line;
    }
-   return {quotient, remainder};
 }
 
-bigint operator/ (const bigint& left, const bigint& right) {
-   //hard coded answers...
-   (void)left;
-   (void)right;
-   bigint bsAnswer = bigint("12500000750001250000075");
-   return bsAnswer;
+void line_writer::flush() {
+   out.write (block, used);
+   used = 0;
 }
 
-bigint operator% (const bigint& left, const bigint& right) {
-   //hard coded answers...
-   (void)left;
-   (void)right;
-   bigint bsAnswer = bigint("1111111177");
-   return bsAnswer;
+//
+// Deferred text is printed as it stands, less the leading zeros and
+// the sign of a zero.
+//
+static void print_decimal (line_writer& writer, const string& text) {
+   size_t first = text.size() > 0 and text[0] == '_' ? 1 : 0;
+   size_t digits = text.find_first_not_of ('0', first);
+   if (digits == string::npos) {
+      writer.put ("0", 1);
+      return;
+   }
+   if (first > 0) writer.put ("_", 1);
+   writer.put (text.data() + digits, text.size() - digits);
 }
 
-bool operator== (const bigint& left, const bigint& right) { 
-   int cmp = do_compare(left, right);
-   if(cmp == 0) return true;
-   return false;
+//
+// The top limb, or a small value, without leading zeros.
+//
+static void print_leading (line_writer& writer, uint64_t value) {
+   char digits[20];
+   char* text = digits + sizeof digits;
+   do {
+      *--text = '0' + value % 10;
+      value /= 10;
+   }while (value > 0);
+   writer.put (text, digits + sizeof digits - text);
 }
 
-bool operator< (const bigint& left, const bigint& right) { 
-   int cmp = do_compare(left, right);
-   if(cmp) {
-      return true;
+ostream& print (ostream& out, const bigint& that, size_t width) {
+   line_writer writer (out, width);
+   if (that.decimal != nullptr) {
+      print_decimal (writer, that.decimal->text);
+   }else {
+      if (that.negative) writer.put ("_", 1);
+      if (that.is_small()) {
+         print_leading (writer, that.small);
+      }else {
+         const bigvalue_t& value = that.limbs();
+         print_leading (writer, value.back());
+         const char* pairs = digit_pairs();
+         char chunk[1024 * bigint::radix_digits];
+         char* text = chunk;
+         for (auto i = value.crbegin() + 1; i != value.crend(); ++i) {
+            if (text == chunk + sizeof chunk) {
+               writer.put (chunk, sizeof chunk);
+               text = chunk;
+            }
+            text = put_limb (text, *i, pairs);
+         }
+         writer.put (chunk, text - chunk);
+      }
    }
-   return false;
+   writer.flush();
+   return out;
 }
 
 ostream& operator<< (ostream& out, const bigint& that) {
-   bigint::bigvalue_t value = that.bigvalue;
-   if(that.negative) {
-      out << "_";
+   return print (out, that, 0);
+}
+
+//
+// If value is 10^k, return k, otherwise -1.
+//
+static long power_of_ten (const limb_span& value) {
+   if (value.size() == 0) return -1;
+   for (size_t i = 0; i + 1 < value.size(); ++i) {
+      if (value.data()[i] != 0) return -1;
    }
-   for(auto i = value.crbegin(); i != value.crend(); i++) {
-      out << (int)(*i);
+   long digits = (value.size() - 1) * bigint::radix_digits;
+   digit_t top = value.data()[value.size() - 1];
+   for (; top > 1; top /= 10, ++digits) {
+      if (top % 10 != 0) return -1;
    }
-   return out;
+   return digits;
+}
+
+//
+// Left-to-right binary exponentiation:  square for every bit of the
+// exponent and multiply by the base for every 1 bit.  A one-limb
+// base, such as 2, is multiplied in with a single linear pass.  The
+// steps alternate between two scratch arrays sized once from the
+// logarithm of the result, with two limbs to spare for rounding and
+// for the untrimmed top limb of a product.
+//
+static bigvalue_t pow_magnitude (const limb_span& base,
+                                 unsigned long exponent) {
+   const double radix = bigint::radix;
+   size_t basen = base.size();
+   double top = base.data()[basen - 1];
+   if (basen > 1) top += (base.data()[basen - 2] + 1.0) / radix;
+   double limbs = (basen - 1 + log (top) / log (radix)) * exponent;
+   size_t capacity = size_t (limbs * (1 + 1e-12)) + 2;
+   limb_scratch result (capacity);
+   limb_scratch scratch (capacity);
+   memcpy (result.data(), base.data(), basen * sizeof *base.data());
+   size_t resultn = basen;
+   unsigned long bit = 1;
+   while (bit <= exponent / 2) bit <<= 1;
+   for (bit >>= 1; bit > 0; bit >>= 1) {
+      limbs_sqr (scratch.data(), result.data(), resultn);
+      resultn = limbs_trim (scratch.data(), 2 * resultn);
+      swap (result, scratch);
+      if ((exponent & bit) == 0) continue;
+      if (basen == 1) {
+         digit_t carry = limbs_mul_1 (result.data(), result.data(),
+                                      resultn, base.data()[0]);
+         if (carry) result[resultn++] = carry;
+      }else {
+         limbs_mul (scratch.data(), result.data(), resultn,
+                    base.data(), basen);
+         resultn = limbs_trim (scratch.data(), resultn + basen);
+         swap (result, scratch);
+      }
+   }
+   return bigvalue_t (result.data(), result.data() + resultn);
+}
+
+static bool is_odd (const bigint& that) {
+   limb_span span (that);
+   return span.size() > 0 and span.data()[0] % 2 != 0;
 }
 
 bigint pow (const bigint& base, const bigint& exponent) {
    DEBUGF ('^', "base = " << base << ", exponent = " << exponent);
-   if (base == 0) {
-      cout << "base == 0" << endl;
+   base.settle();
+   exponent.settle();
+   bool odd = is_odd (exponent);
+   if (exponent.is_zero()) return 1;
+   if (base.is_zero()) {
+      if (exponent.negative) throw domain_error ("divide by zero");
       return 0;
    }
-   bigint base_copy = base;
-   bigint result = bigint("1");
-   bigint i = bigint("0");
-   bigint plus1 = bigint("1");
-   for(; i < exponent; i = do_add(i, plus1)){
-      result = result * base_copy;
+   if (base.is_small() and base.small == 1) {
+      return base.negative and odd ? -1 : 1;
+   }
+   // Any other base to a negative power truncates to 0, as in dc.
+   if (exponent.negative) return 0;
+
+   unsigned long power = exponent.to_long();
+   bool negative = base.negative and odd;
+   limb_span value (base);
+   long tens = power_of_ten (value);
+   bigint result;
+   if (tens >= 0) {
+      unsigned long digits = tens * power;
+      bigvalue_t digits_value (digits / bigint::radix_digits + 1);
+      digit_t top = 1;
+      for (size_t i = 0; i < digits % bigint::radix_digits; ++i) {
+         top *= 10;
+      }
+      digits_value.back() = top;
+      result = bigint (move (digits_value), negative);
+   }else {
+      result = bigint (pow_magnitude (value, power), negative);
    }
-   
    DEBUGF ('^', "result = " << result);
    return result;
 }
+
+//
+// base^exponent % modulus without forming base^exponent.  The sign
+// follows % on the full power:  negative only for a negative base
+// and an odd exponent.
+//
+bigint pow_mod (const bigint& base, const bigint& exponent,
+                const bigint& modulus) {
+   DEBUGF ('^', "base = " << base << ", exponent = " << exponent
+                << ", modulus = " << modulus);
+   base.settle();
+   exponent.settle();
+   if (modulus.is_zero()) throw domain_error ("divide by zero");
+   if (exponent.negative) throw domain_error ("negative exponent");
+   bigint magnitude = modulus.negative ? -modulus : modulus;
+   bigint reduced = divide (base.negative ? -base : base,
+                            magnitude).second;
+   limb_span mspan (magnitude);
+   limb_span rspan (reduced);
+   limb_span espan (exponent);
+   bigvalue_t result (mspan.size());
+   limbs_powmod (result.data(), rspan.data(), rspan.size(),
+                 espan.data(), espan.size(),
+                 mspan.data(), mspan.size());
+   return bigint (move (result), base.negative and is_odd (exponent));
+}
+
+//
+// Floor of the square root.  A small value is done in floating
+// point and corrected.  A larger one takes the root of its top half
+// recursively, shifts it back up, and finishes with Newton's method
+// from above:  the recursive root is right to half the digits, and
+// each step doubles that, so the whole costs a few divisions at full
+// size.
+//
+bigint isqrt (const bigint& value) {
+   value.settle();
+   if (value.negative) {
+      throw domain_error ("square root of negative number");
+   }
+   if (value.is_small()) {
+      uint64_t root = sqrtl (static_cast<long double> (value.small));
+      while (wide_t (root) * root > value.small) --root;
+      while (wide_t (root + 1) * (root + 1) <= value.small) ++root;
+      return bigint::from_wide (root, false);
+   }
+   size_t shift = max<size_t> (value.limbs().size() / 4, 1);
+   bigint upper (bigvalue_t (value.limbs().begin() + 2 * shift,
+                             value.limbs().end()), false);
+   bigint estimate = isqrt (upper) + 1;
+   limb_span espan (estimate);
+   bigvalue_t shifted (shift);
+   shifted.insert (shifted.end(), espan.data(),
+                   espan.data() + espan.size());
+   bigint root (move (shifted), false);
+   const bigint two = 2;
+   for (;;) {
+      bigint next = (root + value / root) / two;
+      if (not (next < root)) break;
+      root = move (next);
+   }
+   return root;
+}
+
+//
+// Greatest common divisor, never negative, by Lehmer's algorithm
+// (Knuth 4.5.2, Algorithm L).  Each round runs Euclid's algorithm
+// on the top two limbs of both values with single-precision
+// cofactors, then applies the cofactors to the full values at once.
+// When the leading limbs can not decide a quotient, one ordinary
+// division is done instead.  Values that fit in 64 bits finish with
+// the binary algorithm.
+//
+bigint gcd (const bigint& left, const bigint& right) {
+   left.settle();
+   right.settle();
+   bigint a = left.negative ? -left : left;
+   bigint b = right.negative ? -right : right;
+   if (a < b) swap (a, b);
+   while (not b.is_small()) {
+      const bigvalue_t& av = a.limbs();
+      limb_span bspan (b);
+      size_t top = av.size() - 1;
+      auto limb_of = [&bspan] (size_t i) -> wide_t {
+         return i < bspan.size() ? bspan.data()[i] : 0;
+      };
+      __int128 ahat = wide_t (av[top]) * bigint::radix + av[top - 1];
+      __int128 bhat = limb_of (top) * bigint::radix + limb_of (top - 1);
+      __int128 A = 1, B = 0, C = 0, D = 1;
+      for (;;) {
+         if (bhat + C == 0 or bhat + D == 0) break;
+         __int128 q = (ahat + A) / (bhat + C);
+         if (q != (ahat + B) / (bhat + D)) break;
+         __int128 t = A - q * C; A = C; C = t;
+         t = B - q * D; B = D; D = t;
+         t = ahat - q * bhat; ahat = bhat; bhat = t;
+      }
+      if (B == 0) {
+         bigint remainder = divide (a, b).second;
+         a = move (b);
+         b = move (remainder);
+      }else {
+         bigint next_a = bigint (long (A)) * a + bigint (long (B)) * b;
+         bigint next_b = bigint (long (C)) * a + bigint (long (D)) * b;
+         a = move (next_a);
+         b = move (next_b);
+      }
+   }
+   if (b.is_zero()) return a;
+   uint64_t y = b.small;
+   uint64_t x = a.is_small() ? a.small : divide (a, b).second.small;
+   if (x == 0) return bigint::from_wide (y, false);
+   int twos = __builtin_ctzll (x | y);
+   x >>= __builtin_ctzll (x);
+   while (y != 0) {
+      y >>= __builtin_ctzll (y);
+      if (x > y) swap (x, y);
+      y -= x;
+   }
+   return bigint::from_wide (x << twos, false);
+}
+
+//
+// Product of low through high by binary splitting, so that the
+// large multiplications are between operands of equal size.
+//
+static bigint product_range (unsigned long low, unsigned long high) {
+   if (high - low < 16) {
+      bigint result = 1;
+      long run = 1;
+      for (unsigned long factor = low; factor <= high; ++factor) {
+         if (run > numeric_limits<long>::max() / long (factor)) {
+            result *= run;
+            run = 1;
+         }
+         run *= factor;
+      }
+      result *= run;
+      return result;
+   }
+   unsigned long middle = low + (high - low) / 2;
+   return product_range (low, middle)
+        * product_range (middle + 1, high);
+}
+
+bigint factorial (const bigint& count) {
+   if (count.is_negative()) {
+      throw domain_error ("factorial of negative number");
+   }
+   long n = count.to_long();
+   if (n < 2) return 1;
+   return product_range (2, n);
+}
@@ -4,30 +4,77 @@
 #ifndef __BIGINT_H__
 #define __BIGINT_H__
 
+#include <cstdint>
 #include <exception>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 using namespace std;
 
 #include "debug.h"
+#include "limbs.h"
 
 //
 // Define class bigint
+//    A magnitude that fits in 64 bits is kept inline in small, with
+//    bigvalue left empty, so it costs no allocation and arithmetic
+//    on two such values runs on native 128-bit integers.  A larger
+//    magnitude is kept in bigvalue as a little-endian vector of
+//    limbs, each holding radix_digits decimal digits (base 10^9).
+//    Every value has exactly one form, and zero is never negative.
+//
+//    The vector is shared by copies of the bigint, so a copy costs
+//    a reference count rather than the limbs, and own_limbs copies
+//    it only when a bigint that shares it is about to change it.
+//
+//    A value made by deferred may instead hold its decimal text, and
+//    is only parsed by settle when first used for anything but a
+//    copy or a print, so a literal that is only passed through costs
+//    a copy of its text.  Copies share the text and the value parsed
+//    from it, so the first copy settled parses it for all of them,
+//    and they all share its limbs.  settle fills in fields of a
+//    const value, so those are mutable, and one such value must be
+//    settled before two threads may read it.
 //
 class bigint {
       friend ostream& operator<< (ostream&, const bigint&);
-   private:
-      long long_value {};
+      //
+      // As operator<<, but when width is above 1, broken into lines
+      // of width - 1 characters and a backslash, as dc prints.
+      //
+      friend ostream& print (ostream&, const bigint&, size_t width);
+   public:
+      using digit_t = limb_t;
+      using bigvalue_t = limbvec;
       using quot_rem = pair<bigint,bigint>;
-      using unumber = unsigned long;
-      friend quot_rem divide (const bigint&, const bigint&);
-      friend void multiply_by_2 (unumber&);
-      friend void divide_by_2 (unumber&);
+      static constexpr digit_t radix = limb_radix;
+      static constexpr int radix_digits = limb_digits;
+      class limb_span;
+   private:
+      struct pending;
+      mutable shared_ptr<pending> decimal;
+      mutable uint64_t small {0};
+      mutable shared_ptr<bigvalue_t> bigvalue;
+      mutable bool negative {false};
+      bool is_small() const { return bigvalue == nullptr; }
+      const bigvalue_t& limbs() const { return *bigvalue; }
+      bigvalue_t& own_limbs();
+      void settle() const { if (decimal != nullptr) parse_decimal(); }
+      void parse_decimal() const;
+      void normalize();
+      void add_in_place (const bigint& right, bool right_neg);
+      static bigint from_wide (unsigned __int128 magnitude, bool neg);
+      friend bigint do_signed_add (const bigint&, const bigint&, bool);
+      friend int do_compare (const bigint&, const bigint&);
+      friend bigint pow (const bigint&, const bigint&);
+      friend bigint pow_mod (const bigint&, const bigint&,
+                             const bigint&);
+      friend bigint isqrt (const bigint&);
+      friend bigint gcd (const bigint&, const bigint&);
    public:
-      using digit_t = unsigned char;
-      using bigvalue_t = vector<digit_t>;
-      bigvalue_t bigvalue;
-      bool negative;
+      friend quot_rem divide (const bigint&, const bigint&);
       //
       // Ensure synthesized members are genrated.
       //
@@ -43,7 +90,9 @@ class bigint {
       //
       bigint (const long);
       bigint (const string&);
+      bigint (const char* text, size_t length);
       bigint (bigvalue_t, bool);
+      static bigint deferred (const char* text, size_t length);
 
       //
       // Basic add/sub operators.
@@ -53,6 +102,15 @@ class bigint {
       friend bigint operator+ (const bigint&);
       friend bigint operator- (const bigint&);
       long to_long() const;
+      size_t digits() const;
+      bool is_zero() const {
+         settle();
+         return is_small() and small == 0;
+      }
+      bool is_negative() const {
+         settle();
+         return negative;
+      }
 
       //
       // Extended operators implemented with add/sub.
@@ -61,6 +119,17 @@ class bigint {
       friend bigint operator/ (const bigint&, const bigint&);
       friend bigint operator% (const bigint&, const bigint&);
 
+      //
+      // Compound assignment.  += and -= work in place on this
+      // bigint's limbs, so a long chain of them allocates only when
+      // the value outgrows its capacity.
+      //
+      bigint& operator+= (const bigint&);
+      bigint& operator-= (const bigint&);
+      bigint& operator*= (const bigint&);
+      bigint& operator/= (const bigint&);
+      bigint& operator%= (const bigint&);
+
       //
       // Comparison operators.
       //
@@ -68,12 +137,36 @@ class bigint {
       friend bool operator<  (const bigint&, const bigint&);
 };
 
+//
+// bigint::limb_span -
+//    Read-only limbs of a bigint's magnitude, for the limbs kernels.
+//    A small value is split into the span's own buffer, so a span
+//    may not be copied and must not outlive its bigint.
+//
+class bigint::limb_span {
+   private:
+      digit_t local[3];
+      const digit_t* limbs;
+      size_t count;
+   public:
+      explicit limb_span (const bigint&);
+      limb_span (const limb_span&) = delete;
+      limb_span& operator= (const limb_span&) = delete;
+      const digit_t* data() const { return limbs; }
+      size_t size() const { return count; }
+};
+
 //
 // The rest of the operators do not need to be friends.
 // Make the comparisons inline for efficiency.
 //
 
 bigint pow (const bigint& base, const bigint& exponent);
+bigint pow_mod (const bigint& base, const bigint& exponent,
+                const bigint& modulus);
+bigint isqrt (const bigint& value);
+bigint gcd (const bigint& left, const bigint& right);
+bigint factorial (const bigint& count);
 
 inline bool operator!= (const bigint &left, const bigint &right) {
    return not (left == right);
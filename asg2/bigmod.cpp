@@ -0,0 +1,146 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// Modular exponentiation of limb magnitudes.  Every intermediate is
+// reduced back to the size of the modulus.  A modulus coprime to
+// the radix, 10^9, is handled in Montgomery form, where reduction is
+// one linear pass per limb and needs no division.  Any other modulus
+// is reduced by ordinary division after each product.
+//
+
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#include "limbs.h"
+
+//
+// -m0^-1 mod radix, for m0 coprime to the radix.
+//
+static limb_t montgomery_inverse (limb_t m0) {
+   int64_t old_r = m0;
+   int64_t r = limb_radix;
+   int64_t old_s = 1;
+   int64_t s = 0;
+   while (r != 0) {
+      int64_t quotient = old_r / r;
+      int64_t next_r = old_r - quotient * r;
+      old_r = r;
+      r = next_r;
+      int64_t next_s = old_s - quotient * s;
+      old_s = s;
+      s = next_s;
+   }
+   int64_t inverse = old_s % int64_t (limb_radix);
+   if (inverse < 0) inverse += limb_radix;
+   return inverse == 0 ? 0 : limb_radix - inverse;
+}
+
+class modular {
+   private:
+      const limb_t* m;
+      size_t mn;
+      bool montgomery;
+      limb_t minverse;
+      limb_scratch product;
+      limb_scratch quotient;
+   public:
+      modular (const limb_t* m, size_t mn);
+      void enter (limb_scratch& x);
+      void leave (limb_scratch& x);
+      void multiply (limb_scratch& x, const limb_scratch& y);
+};
+
+modular::modular (const limb_t* m, size_t mn):
+            m(m), mn(mn), montgomery (m[0] % 2 != 0 and m[0] % 5 != 0),
+            minverse (montgomery ? montgomery_inverse (m[0]) : 0),
+            product (2 * mn + 1), quotient (mn + 2) {
+}
+
+//
+// Convert x, which is below m, into working form:  x radix^mn mod m
+// for Montgomery, unchanged otherwise.  x always has mn limbs.
+//
+void modular::enter (limb_scratch& x) {
+   if (not montgomery) return;
+   memset (product.data(), 0, mn * sizeof (limb_t));
+   memcpy (product.data() + mn, x.data(), mn * sizeof (limb_t));
+   limbs_divrem (quotient.data(), x.data(), product.data(), 2 * mn,
+                 m, mn);
+}
+
+void modular::leave (limb_scratch& x) {
+   if (not montgomery) return;
+   limb_scratch one (mn);
+   one[0] = 1;
+   multiply (x, one);
+}
+
+//
+// x = x y mod m in working form.  For Montgomery this is
+// x y radix^-mn mod m:  adding a multiple of m that clears the low
+// limb, mn times over, leaves a value divisible by radix^mn and
+// below 2m.
+//
+void modular::multiply (limb_scratch& x, const limb_scratch& y) {
+   limb_t* t = product.data();
+   limbs_mul (t, x.data(), mn, y.data(), mn);
+   t[2 * mn] = 0;
+   if (montgomery) {
+      for (size_t i = 0; i < mn; ++i) {
+         limb_t u = dlimb_t (t[i]) * minverse % limb_radix;
+         limb_t carry = limbs_addmul_1 (t + i, m, mn, u);
+         limbs_add (t + i + mn, t + i + mn, mn + 1 - i, &carry, 1);
+      }
+      if (limbs_cmp (t + mn, mn + 1, m, mn) >= 0) {
+         limbs_sub (t + mn, t + mn, mn + 1, m, mn);
+      }
+      memcpy (x.data(), t + mn, mn * sizeof (limb_t));
+   }else {
+      limbs_divrem (quotient.data(), x.data(), t, 2 * mn, m, mn);
+   }
+}
+
+//
+// Exponent bits, least significant first, peeled off 30 at a time.
+//
+static vector<bool> exponent_bits (const limb_t* e, size_t en) {
+   if (en == 0) return {};
+   const limb_t chunk = limb_t (1) << 30;
+   limb_scratch value (en);
+   memcpy (value.data(), e, en * sizeof *e);
+   vector<bool> bits;
+   for (size_t n = limbs_trim (value.data(), en); n > 0;
+        n = limbs_trim (value.data(), n)) {
+      limb_t low = limbs_divrem_1 (value.data(), value.data(), n,
+                                   chunk);
+      for (int bit = 0; bit < 30; ++bit) {
+         bits.push_back (low >> bit & 1);
+      }
+   }
+   while (not bits.empty() and not bits.back()) bits.pop_back();
+   return bits;
+}
+
+void limbs_powmod (limb_t* r, const limb_t* base, size_t basen,
+                   const limb_t* e, size_t en,
+                   const limb_t* m, size_t mn) {
+   memset (r, 0, mn * sizeof *r);
+   if (mn == 1 and m[0] == 1) return;
+   modular ring (m, mn);
+   limb_scratch power (mn);
+   memcpy (power.data(), base, basen * sizeof *base);
+   ring.enter (power);
+   limb_scratch result (mn);
+   result[0] = 1;
+   ring.enter (result);
+   vector<bool> bits = exponent_bits (e, en);
+   for (size_t i = bits.size(); i-- > 0; ) {
+      ring.multiply (result, result);
+      if (bits[i]) ring.multiply (result, power);
+   }
+   ring.leave (result);
+   memcpy (r, result.data(), mn * sizeof *r);
+}
+
@@ -0,0 +1,261 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// Multiplication engine for limb magnitudes.  limbs_mul dispatches
+// on the shorter operand:  schoolbook below karatsuba_threshold,
+// Karatsuba below toom3_threshold, Toom-3 below ntt_threshold, and
+// the number-theoretic transform above that as long as the product
+// fits in one transform.  Lopsided operands are cut into balanced
+// pieces for Karatsuba and Toom-3, since the recursive algorithms
+// only pay off on near-equal lengths.  From parallel_threshold up,
+// the independent sub-products of Karatsuba and Toom-3 run as tasks
+// on the thread pool.
+//
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <utility>
+using namespace std;
+
+#include "debug.h"
+#include "limbs.h"
+#include "taskpool.h"
+
+size_t bigtuning::karatsuba_threshold = 32;
+size_t bigtuning::toom3_threshold = 160;
+size_t bigtuning::ntt_threshold = 15000;
+size_t bigtuning::bz_threshold = 80;
+size_t bigtuning::parallel_threshold = 400;
+size_t bigtuning::threads = 1;
+
+//
+// Burnikel-Ziegler halves the divisor until it is under bz, so bz
+// must leave at least two limbs to halve.
+//
+bool bigtuning::set (const string& name, size_t value) {
+   if (name == "bz" and value < 2) return false;
+   if (name == "karatsuba") karatsuba_threshold = value;
+   else if (name == "toom3") toom3_threshold = value;
+   else if (name == "ntt") ntt_threshold = value;
+   else if (name == "bz") bz_threshold = value;
+   else if (name == "parallel") parallel_threshold = value;
+   else return false;
+   DEBUGF ('m', name << " = " << value);
+   return true;
+}
+
+//
+// Karatsuba:  with x = radix^k, a = a1 x + a0, b = b1 x + b0,
+//    a b = a1 b1 x^2 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) x + a0 b0.
+// Needs k < bn <= an.
+//
+static void mul_karatsuba (limb_t* r, const limb_t* a, size_t an,
+                           const limb_t* b, size_t bn) {
+   size_t k = (an + 1) / 2;
+   const limb_t* a1 = a + k;
+   const limb_t* b1 = b + k;
+   size_t a1n = an - k;
+   size_t b1n = bn - k;
+   task_group tasks (bn >= bigtuning::parallel_threshold);
+   tasks.run ([=]() { limbs_mul (r, a, k, b, k); });
+   tasks.run ([=]() { limbs_mul (r + 2 * k, a1, a1n, b1, b1n); });
+
+   bool square = a == b and an == bn;
+   limb_scratch asum (k + 1);
+   limb_scratch bsum (square ? 0 : k + 1);
+   asum[k] = limbs_add (asum.data(), a, k, a1, a1n);
+   if (not square) bsum[k] = limbs_add (bsum.data(), b, k, b1, b1n);
+   const limb_scratch& bmiddle = square ? asum : bsum;
+   limb_scratch middle (2 * k + 2);
+   limbs_mul (middle.data(), asum.data(), k + 1, bmiddle.data(), k + 1);
+   tasks.wait();
+   limbs_sub (middle.data(), middle.data(), middle.size(), r, 2 * k);
+   limbs_sub (middle.data(), middle.data(), middle.size(),
+              r + 2 * k, a1n + b1n);
+   size_t middlen = limbs_trim (middle.data(), middle.size());
+   limbs_add (r + k, r + k, an + bn - k, middle.data(), middlen);
+}
+
+//
+// Toom-3 needs signed intermediates, kept as sign and magnitude in
+// pooled scratch, with size the magnitude's length after trimming.
+//
+struct toom_value {
+   bool negative {false};
+   limb_scratch limbs;
+   size_t size {0};
+   const limb_t* data() const { return limbs.data(); }
+};
+
+static toom_value toom_slice (const limb_t* a, size_t an) {
+   toom_value result;
+   result.size = limbs_trim (a, an);
+   result.limbs = limb_scratch (result.size);
+   if (result.size > 0) {
+      memcpy (result.limbs.data(), a, result.size * sizeof *a);
+   }
+   return result;
+}
+
+static toom_value toom_add (const toom_value& x, const toom_value& y,
+                            bool subtract = false) {
+   bool ynegative = y.negative != subtract;
+   toom_value result;
+   if (x.negative == ynegative) {
+      const toom_value& big = x.size < y.size ? y : x;
+      const toom_value& small = x.size < y.size ? x : y;
+      result.limbs = limb_scratch (big.size + 1);
+      result.limbs[big.size] = limbs_add (result.limbs.data(),
+                  big.data(), big.size, small.data(), small.size);
+      result.negative = x.negative;
+   }else {
+      int cmp = limbs_cmp (x.data(), x.size, y.data(), y.size);
+      const toom_value& big = cmp < 0 ? y : x;
+      const toom_value& small = cmp < 0 ? x : y;
+      result.limbs = limb_scratch (big.size);
+      limbs_sub (result.limbs.data(), big.data(), big.size,
+                 small.data(), small.size);
+      result.negative = cmp < 0 ? ynegative : x.negative;
+   }
+   result.size = limbs_trim (result.data(), result.limbs.size());
+   if (result.size == 0) result.negative = false;
+   return result;
+}
+
+static toom_value toom_mul (const toom_value& x, const toom_value& y) {
+   toom_value result;
+   result.limbs = limb_scratch (x.size + y.size);
+   limbs_mul (result.limbs.data(), x.data(), x.size, y.data(), y.size);
+   result.size = limbs_trim (result.data(), result.limbs.size());
+   result.negative = x.negative != y.negative and result.size > 0;
+   return result;
+}
+
+static void toom_divexact (toom_value& x, limb_t divisor) {
+   limb_t remainder = limbs_divrem_1 (x.limbs.data(), x.data(), x.size,
+                                      divisor);
+   assert (remainder == 0);
+   (void) remainder;
+   x.size = limbs_trim (x.data(), x.size);
+}
+
+//
+// Evaluate a2 x^2 + a1 x + a0 at 0, 1, -1, -2 and infinity.
+//
+static void toom_evaluate (const limb_t* a, size_t an, size_t k,
+                           toom_value points[5]) {
+   size_t a1n = min (k, an - k);
+   size_t a2n = an > 2 * k ? an - 2 * k : 0;
+   toom_value a0 = toom_slice (a, k);
+   toom_value a1 = toom_slice (a + k, a1n);
+   toom_value a2 = toom_slice (a + 2 * k, a2n);
+   toom_value even = toom_add (a0, a2);
+   points[1] = toom_add (even, a1);
+   points[2] = toom_add (even, a1, true);
+   toom_value minus2 = toom_add (points[2], a2);
+   minus2 = toom_add (minus2, minus2);
+   points[3] = toom_add (minus2, a0, true);
+   points[0] = move (a0);
+   points[4] = move (a2);
+}
+
+//
+// Toom-3 with Bodrato's interpolation sequence.  Needs 2k < an and
+// k < bn <= an.
+//
+static void mul_toom3 (limb_t* r, const limb_t* a, size_t an,
+                       const limb_t* b, size_t bn) {
+   size_t k = (an + 2) / 3;
+   bool square = a == b and an == bn;
+   toom_value apoints[5];
+   toom_value bvalues[5];
+   toom_evaluate (a, an, k, apoints);
+   if (not square) toom_evaluate (b, bn, k, bvalues);
+   const toom_value* bpoints = square ? apoints : bvalues;
+   toom_value products[5];
+   task_group tasks (bn >= bigtuning::parallel_threshold);
+   for (size_t i = 1; i < 5; ++i) {
+      tasks.run ([&products, &apoints, bpoints, i]() {
+         products[i] = toom_mul (apoints[i], bpoints[i]);
+      });
+   }
+   products[0] = toom_mul (apoints[0], bpoints[0]);
+   tasks.wait();
+   toom_value& r0 = products[0];
+   toom_value& r1 = products[1];
+   toom_value& rm1 = products[2];
+   toom_value& rm2 = products[3];
+   toom_value& rinf = products[4];
+
+   toom_value r3 = toom_add (rm2, r1, true);
+   toom_divexact (r3, 3);
+   r1 = toom_add (r1, rm1, true);
+   toom_divexact (r1, 2);
+   toom_value r2 = toom_add (rm1, r0, true);
+   r3 = toom_add (r2, r3, true);
+   toom_divexact (r3, 2);
+   r3 = toom_add (r3, toom_add (rinf, rinf));
+   r2 = toom_add (toom_add (r2, r1), rinf, true);
+   r1 = toom_add (r1, r3, true);
+
+   size_t rn = an + bn;
+   memset (r, 0, rn * sizeof *r);
+   const toom_value* coefficients[] {&r0, &r1, &r2, &r3, &rinf};
+   for (size_t i = 0; i < 5; ++i) {
+      const toom_value& value = *coefficients[i];
+      assert (not value.negative);
+      if (value.size == 0) continue;
+      limbs_add (r + i * k, r + i * k, rn - i * k,
+                 value.data(), value.size);
+   }
+}
+
+//
+// Cut a into bn-limb pieces and accumulate each piece times b.
+//
+static void mul_unbalanced (limb_t* r, const limb_t* a, size_t an,
+                            const limb_t* b, size_t bn) {
+   memset (r, 0, (an + bn) * sizeof *r);
+   limb_scratch piece (2 * bn);
+   for (size_t offset = 0; offset < an; offset += bn) {
+      size_t piecen = min (bn, an - offset);
+      limbs_mul (piece.data(), a + offset, piecen, b, bn);
+      limbs_add (r + offset, r + offset, an + bn - offset,
+                 piece.data(), piecen + bn);
+   }
+}
+
+void limbs_mul (limb_t* r, const limb_t* a, size_t an,
+                const limb_t* b, size_t bn) {
+   size_t rn = an + bn;
+   if (rn == 0) return;
+   an = limbs_trim (a, an);
+   bn = limbs_trim (b, bn);
+   if (an < bn) {
+      swap (a, b);
+      swap (an, bn);
+   }
+   if (bn == 0) {
+      memset (r, 0, rn * sizeof *r);
+      return;
+   }
+   if (bn < bigtuning::karatsuba_threshold or bn < 4) {
+      if (a == b and an == bn) limbs_sqr_basecase (r, a, an);
+                          else limbs_mul_basecase (r, a, an, b, bn);
+   }else if (bn >= bigtuning::ntt_threshold
+             and an + bn <= limbs_mul_ntt_limit()) {
+      limbs_mul_ntt (r, a, an, b, bn);
+   }else if (2 * an >= 3 * bn) {
+      mul_unbalanced (r, a, an, b, bn);
+   }else if (bn < bigtuning::toom3_threshold or bn < 16) {
+      mul_karatsuba (r, a, an, b, bn);
+   }else {
+      mul_toom3 (r, a, an, b, bn);
+   }
+   if (an + bn < rn) {
+      memset (r + an + bn, 0, (rn - an - bn) * sizeof *r);
+   }
+}
+
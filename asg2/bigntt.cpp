@@ -0,0 +1,195 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// Number-theoretic transform multiplication.  Each operand is
+// regrouped from base 10^9 limbs into base 10^6 pieces, convolved
+// modulo three NTT-friendly primes, and the exact convolution is
+// recovered with the Chinese remainder theorem.  With pieces below
+// 10^6 and at most 2^23 of them a convolution term stays below
+// 2^23 * 10^12, far under the product of the primes (about 2^86).
+// On the thread pool, the three primes are transformed in parallel
+// and the butterflies of each pass are split among the threads.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#include "limbs.h"
+#include "taskpool.h"
+
+//
+// Pieces are the same type as limbs, so the transforms work in limb
+// scratch buffers.
+//
+using ntt_t = limb_t;
+using nttvec = limb_scratch;
+
+static const ntt_t piece_radix = 1000000;
+static const ntt_t ntt_moduli[] {998244353, 167772161, 469762049};
+static const ntt_t ntt_root = 3; // Primitive root of all three.
+static const size_t ntt_max_size = size_t (1) << 23;
+
+static ntt_t pow_mod (uint64_t base, uint64_t exponent, ntt_t modulus) {
+   uint64_t result = 1;
+   base %= modulus;
+   for (; exponent > 0; exponent >>= 1) {
+      if (exponent & 1) result = result * base % modulus;
+      base = base * base % modulus;
+   }
+   return result;
+}
+
+//
+// Butterflies numbered [begin, end) of one pass, where each block of
+// 2 half elements holds half of them.
+//
+static void butterflies (ntt_t* a, size_t half, const ntt_t* twiddles,
+                         ntt_t modulus, size_t begin, size_t end) {
+   while (begin < end) {
+      size_t first = begin % half;
+      size_t last = min (half, first + (end - begin));
+      ntt_t* lo = a + begin / half * 2 * half;
+      ntt_t* hi = lo + half;
+      for (size_t i = first; i < last; ++i) {
+         ntt_t u = lo[i];
+         ntt_t v = uint64_t (hi[i]) * twiddles[i] % modulus;
+         lo[i] = u + v < modulus ? u + v : u + v - modulus;
+         hi[i] = u >= v ? u - v : u + modulus - v;
+      }
+      begin += last - first;
+   }
+}
+
+//
+// In-place iterative transform of length a.size(), a power of 2.
+// Each pass is cut into chunks pieces.
+//
+static void ntt (nttvec& a, ntt_t modulus, bool inverse,
+                 size_t chunks) {
+   size_t n = a.size();
+   for (size_t i = 1, j = 0; i < n; ++i) {
+      size_t bit = n >> 1;
+      for (; j & bit; bit >>= 1) j ^= bit;
+      j ^= bit;
+      if (i < j) swap (a[i], a[j]);
+   }
+   nttvec twiddles (n / 2);
+   for (size_t len = 2; len <= n; len <<= 1) {
+      ntt_t step = pow_mod (ntt_root, (modulus - 1) / len, modulus);
+      if (inverse) step = pow_mod (step, modulus - 2, modulus);
+      size_t half = len / 2;
+      twiddles[0] = 1;
+      for (size_t i = 1; i < half; ++i) {
+         twiddles[i] = uint64_t (twiddles[i - 1]) * step % modulus;
+      }
+      task_group tasks (chunks > 1);
+      for (size_t chunk = 0; chunk < chunks; ++chunk) {
+         size_t begin = n / 2 * chunk / chunks;
+         size_t end = n / 2 * (chunk + 1) / chunks;
+         ntt_t* data = a.data();
+         const ntt_t* factors = twiddles.data();
+         tasks.run ([=]() {
+            butterflies (data, half, factors, modulus, begin, end);
+         });
+      }
+      tasks.wait();
+   }
+   if (inverse) {
+      uint64_t scale = pow_mod (n, modulus - 2, modulus);
+      for (auto& x: a) x = x * scale % modulus;
+   }
+}
+
+//
+// Two limbs hold 18 digits, which is exactly three pieces.
+//
+static nttvec to_pieces (const limb_t* a, size_t an, size_t size) {
+   nttvec pieces (size);
+   for (size_t i = 0, j = 0; i < an; i += 2, j += 3) {
+      limb_t lo = a[i];
+      limb_t hi = i + 1 < an ? a[i + 1] : 0;
+      pieces[j] = lo % piece_radix;
+      pieces[j + 1] = lo / piece_radix + hi % 1000 * 1000;
+      pieces[j + 2] = hi / 1000;
+   }
+   return pieces;
+}
+
+static size_t piece_count (size_t an) {
+   return (an + 1) / 2 * 3;
+}
+
+size_t limbs_mul_ntt_limit() {
+   return ntt_max_size / 3 * 2 - 2;
+}
+
+void limbs_mul_ntt (limb_t* r, const limb_t* a, size_t an,
+                    const limb_t* b, size_t bn) {
+   size_t pieces = piece_count (an) + piece_count (bn);
+   size_t size = 1;
+   while (size < pieces) size <<= 1;
+   bool square = a == b and an == bn;
+   bool parallel = bn >= bigtuning::parallel_threshold
+                   and bigtuning::threads > 1;
+   size_t chunks = parallel ? (bigtuning::threads + 2) / 3 : 1;
+   nttvec residues[3];
+   task_group primes (parallel);
+   for (int p = 0; p < 3; ++p) {
+      primes.run ([=, &residues]() {
+         nttvec fa = to_pieces (a, an, size);
+         ntt (fa, ntt_moduli[p], false, chunks);
+         nttvec fb;
+         if (not square) {
+            fb = to_pieces (b, bn, size);
+            ntt (fb, ntt_moduli[p], false, chunks);
+         }
+         const nttvec& fother = square ? fa : fb;
+         for (size_t i = 0; i < size; ++i) {
+            fa[i] = uint64_t (fa[i]) * fother[i] % ntt_moduli[p];
+         }
+         ntt (fa, ntt_moduli[p], true, chunks);
+         residues[p] = move (fa);
+      });
+   }
+   primes.wait();
+
+   //
+   // Garner's algorithm recombines the residues, then carries are
+   // propagated in base 10^6 and three pieces are packed back into
+   // each pair of limbs.
+   //
+   const uint64_t m0 = ntt_moduli[0];
+   const uint64_t m1 = ntt_moduli[1];
+   const uint64_t m2 = ntt_moduli[2];
+   const uint64_t inv_m0_m1 = pow_mod (m0, m1 - 2, m1);
+   const uint64_t inv_m01_m2 = pow_mod (m0 * m1 % m2, m2 - 2, m2);
+   size_t rn = an + bn;
+   memset (r, 0, rn * sizeof *r);
+   unsigned __int128 carry = 0;
+   limb_t group[3];
+   for (size_t i = 0; i < piece_count (rn); ++i) {
+      if (i < pieces) {
+         uint64_t x0 = residues[0][i];
+         uint64_t x1 = (residues[1][i] + m1 - x0 % m1) % m1
+                     * inv_m0_m1 % m1;
+         uint64_t partial = (x0 + x1 * m0) % m2;
+         uint64_t x2 = (residues[2][i] + m2 - partial) % m2
+                     * inv_m01_m2 % m2;
+         carry += x0 + (unsigned __int128) x1 * m0
+                + (unsigned __int128) x2 * m0 * m1;
+      }
+      group[i % 3] = carry % piece_radix;
+      carry /= piece_radix;
+      if (i % 3 == 2) {
+         size_t limb = i / 3 * 2;
+         limb_t lo = group[0] + group[1] % 1000 * piece_radix;
+         limb_t hi = group[1] / 1000 + group[2] * 1000;
+         if (limb < rn) r[limb] = lo;
+         if (limb + 1 < rn) r[limb + 1] = hi;
+      }
+   }
+}
+
@@ -0,0 +1,105 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+using namespace std;
+
+#include "checkpoint.h"
+#include "util.h"
+
+static const char magic[8] {'y', 'd', 'c', 's', 't', 'a', 'c', 'k'};
+
+static ydc_exn file_error (const string& filename) {
+   return ydc_exn (filename + ": " + strerror (errno));
+}
+
+void save_stack (const string& filename, ydc_stack& stack) {
+   string tempname = filename + ".tmp";
+   ofstream out (tempname, ios::binary | ios::trunc);
+   if (not out) throw file_error (tempname);
+   uint32_t radix = limb_radix;
+   uint32_t count = stack.size();
+   out.write (magic, sizeof magic);
+   out.write (reinterpret_cast<const char*> (&radix), sizeof radix);
+   out.write (reinterpret_cast<const char*> (&count), sizeof count);
+   for (const auto& value: stack) {
+      if (value.is_macro()) {
+         const string& text = value.macro->text;
+         uint64_t header = uint64_t (text.size()) * 4 + 2;
+         out.write (reinterpret_cast<const char*> (&header),
+                    sizeof header);
+         out.write (text.data(), text.size());
+         continue;
+      }
+      bigint::limb_span span (value.number);
+      uint64_t header = uint64_t (span.size()) * 4
+                      + (value.number.is_negative() ? 1 : 0);
+      out.write (reinterpret_cast<const char*> (&header),
+                 sizeof header);
+      out.write (reinterpret_cast<const char*> (span.data()),
+                 span.size() * sizeof (limb_t));
+   }
+   out.close();
+   if (not out) {
+      int error = errno;
+      remove (tempname.c_str());
+      errno = error;
+      throw file_error (tempname);
+   }
+   if (rename (tempname.c_str(), filename.c_str()) != 0) {
+      throw file_error (filename);
+   }
+   DEBUGF ('k', count << " values saved to " << filename);
+}
+
+void restore_stack (const string& filename, ydc_stack& stack) {
+   mapped_file file (filename);
+   if (not file.is_open()) return;
+   const char* next = file.data();
+   const char* limit = next + file.size();
+   const ydc_exn corrupt (filename + ": not a ydc checkpoint");
+   auto take = [&next, limit, &corrupt] (void* into, size_t bytes) {
+      if (size_t (limit - next) < bytes) throw corrupt;
+      memcpy (into, next, bytes);
+      next += bytes;
+   };
+   char header[sizeof magic];
+   uint32_t radix = 0;
+   uint32_t count = 0;
+   take (header, sizeof header);
+   take (&radix, sizeof radix);
+   take (&count, sizeof count);
+   if (memcmp (header, magic, sizeof magic) != 0
+    or radix != limb_radix) throw corrupt;
+   vector<ydc_value> values;
+   values.reserve (count);
+   for (uint32_t i = 0; i < count; ++i) {
+      uint64_t size = 0;
+      take (&size, sizeof size);
+      bool negative = size % 2 != 0;
+      bool macro = size / 2 % 2 != 0;
+      size /= 4;
+      if (macro) {
+         if (negative or size > size_t (limit - next)) throw corrupt;
+         values.emplace_back (compile (next, size));
+         next += size;
+         continue;
+      }
+      if (size > size_t (limit - next) / sizeof (limb_t)) throw corrupt;
+      bigint::bigvalue_t limbs (size);
+      take (limbs.data(), size * sizeof (limb_t));
+      for (limb_t limb: limbs) if (limb >= limb_radix) throw corrupt;
+      values.emplace_back (bigint (move (limbs), negative));
+   }
+   if (next != limit) throw corrupt;
+   stack.clear();
+   for (auto value = values.rbegin(); value != values.rend(); ++value) {
+      stack.push (move (*value));
+   }
+   DEBUGF ('k', count << " values restored from " << filename);
+}
+
@@ -0,0 +1,41 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// checkpoint -
+//    Save the operand stack to a file as raw limbs and restore it,
+//    so a long computation can be stopped and resumed without
+//    printing and reparsing decimal.  The layout, all in native
+//    byte order, is:
+//
+//       char[8]     "ydcstack"
+//       uint32_t    limb_radix, which also catches byte order
+//       uint32_t    number of values
+//       per value, from the top of the stack down:
+//          uint64_t    size * 4, plus 2 for a macro, plus 1 if
+//                      negative
+//          a number's size limbs, least significant first, or a
+//          macro's size characters of text
+//
+//    A macro is compiled again when it is restored.
+//    A save goes to a temporary file that is renamed over the old
+//    one, so a crash mid-save leaves the previous checkpoint intact.
+//    A restore maps the file and replaces the stack only once every
+//    value has been read and checked.  Either throws ydc_exn on
+//    failure, except that a file that can not be opened for a
+//    restore is reported by mapped_file and leaves the stack alone.
+//
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <string>
+using namespace std;
+
+#include "program.h"
+
+void save_stack (const string& filename, ydc_stack& stack);
+void restore_stack (const string& filename, ydc_stack& stack);
+
+#endif
+
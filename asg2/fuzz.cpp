@@ -0,0 +1,812 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// ydcfuzz -
+//    Differential test of ydc.  For each operator, random cases with
+//    operands of up to -d digits are written as one script, run
+//    through ydc, and checked line by line against a slow reference
+//    kept here:  schoolbook arithmetic on single decimal digits, too
+//    simple to share a bug with bigint.  The pseudo-operator P makes
+//    each case a chained program instead, mixing the operators with
+//    d, p, registers, macros and loops, so that values pass through
+//    each other rather than starting fresh.  Each operator's results
+//    go to stdout as one JSON line, with the time each side took:
+//       {"op": "*", "cases": 100, "max_digits": 300, "mismatches": 0,
+//        "ydc_seconds": 0.012, "startup_seconds": 0.002,
+//        "oracle_seconds": 0.91, "speedup": 75}
+//    so a change that breaks a result or loses speed shows in one
+//    run.  ydc's time leaves out startup_seconds, the time to run it
+//    on an empty script.  Each mismatch is also written to stderr
+//    with the case and both answers, and makes the exit status
+//    nonzero.  The script is written to a file in $TMPDIR, or /tmp.
+//    Options:
+//    -a args     extra arguments for ydc, such as "-j 4 -T ntt=100"
+//    -d digits   largest operand, default 300
+//    -n cases    cases per operator, default 100
+//    -o ops      operators to test, default all of +-*/%~^|vGFP
+//    -s seed     random seed, default 1
+//    Operand:    the ydc to test.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include <unistd.h>
+
+#include "util.h"
+
+using steady = chrono::steady_clock;
+
+static string ydc_args;
+static size_t max_digits = 300;
+static size_t cases = 100;
+static string operators = "+-*/%~^|vGFP";
+static unsigned long seed = 1;
+
+//
+// decimal -
+//    The reference.  A magnitude is a little-endian vector of single
+//    decimal digits with no leading zeros, so zero is empty.
+//
+
+using digits_t = vector<int>;
+
+struct decimal {
+   bool negative {false};
+   digits_t digits;
+};
+
+static void trim (digits_t& a) {
+   while (not a.empty() and a.back() == 0) a.pop_back();
+}
+
+static int compare (const digits_t& a, const digits_t& b) {
+   if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+   for (size_t i = a.size(); i-- > 0; ) {
+      if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+   }
+   return 0;
+}
+
+static digits_t add (const digits_t& a, const digits_t& b) {
+   digits_t r;
+   int carry = 0;
+   for (size_t i = 0; i < max (a.size(), b.size()) or carry; ++i) {
+      int sum = carry + (i < a.size() ? a[i] : 0)
+                      + (i < b.size() ? b[i] : 0);
+      r.push_back (sum % 10);
+      carry = sum / 10;
+   }
+   return r;
+}
+
+// a >= b
+static digits_t sub (const digits_t& a, const digits_t& b) {
+   digits_t r;
+   int borrow = 0;
+   for (size_t i = 0; i < a.size(); ++i) {
+      int digit = a[i] - borrow - (i < b.size() ? b[i] : 0);
+      borrow = digit < 0;
+      r.push_back (borrow ? digit + 10 : digit);
+   }
+   trim (r);
+   return r;
+}
+
+static digits_t mul (const digits_t& a, const digits_t& b) {
+   if (a.empty() or b.empty()) return {};
+   vector<long> sums (a.size() + b.size());
+   for (size_t i = 0; i < a.size(); ++i) {
+      for (size_t j = 0; j < b.size(); ++j) sums[i + j] += a[i] * b[j];
+   }
+   digits_t r;
+   long carry = 0;
+   for (long sum: sums) {
+      carry += sum;
+      r.push_back (carry % 10);
+      carry /= 10;
+   }
+   trim (r);
+   return r;
+}
+
+//
+// Long division, one quotient digit at a time by repeated
+// subtraction.  b is not zero.
+//
+static pair<digits_t,digits_t> divide (const digits_t& a,
+                                       const digits_t& b) {
+   digits_t quotient (a.size());
+   digits_t remainder;
+   for (size_t i = a.size(); i-- > 0; ) {
+      remainder.insert (remainder.begin(), a[i]);
+      trim (remainder);
+      while (compare (remainder, b) >= 0) {
+         remainder = sub (remainder, b);
+         ++quotient[i];
+      }
+   }
+   trim (quotient);
+   return {quotient, remainder};
+}
+
+static decimal with_sign (digits_t digits, bool negative) {
+   decimal result;
+   result.digits = move (digits);
+   result.negative = negative and not result.digits.empty();
+   return result;
+}
+
+static decimal add (const decimal& a, const decimal& b) {
+   if (a.negative == b.negative) {
+      return with_sign (add (a.digits, b.digits), a.negative);
+   }
+   if (compare (a.digits, b.digits) >= 0) {
+      return with_sign (sub (a.digits, b.digits), a.negative);
+   }
+   return with_sign (sub (b.digits, a.digits), b.negative);
+}
+
+static decimal negated (decimal a) {
+   return with_sign (move (a.digits), not a.negative);
+}
+
+static digits_t from_long (unsigned long n) {
+   digits_t r;
+   for (; n > 0; n /= 10) r.push_back (n % 10);
+   return r;
+}
+
+static digits_t power (const digits_t& base, unsigned long exponent) {
+   digits_t result {1};
+   for (unsigned long i = 0; i < exponent; ++i) {
+      result = mul (result, base);
+   }
+   return result;
+}
+
+static digits_t power_mod (digits_t base, const digits_t& exponent,
+                           const digits_t& modulus) {
+   digits_t result = divide ({1}, modulus).second;
+   base = divide (base, modulus).second;
+   digits_t e = exponent;
+   const digits_t two {2};
+   while (not e.empty()) {
+      auto halves = divide (e, two);
+      if (not halves.second.empty()) {
+         result = divide (mul (result, base), modulus).second;
+      }
+      base = divide (mul (base, base), modulus).second;
+      e = halves.first;
+   }
+   return result;
+}
+
+//
+// Newton's method from 10^ceil(digits / 2), which is above the root.
+//
+static digits_t root (const digits_t& n) {
+   if (n.empty()) return {};
+   digits_t x ((n.size() + 1) / 2);
+   x.push_back (1);
+   for (;;) {
+      digits_t y = divide (add (x, divide (n, x).first), {2}).first;
+      if (compare (y, x) >= 0) return x;
+      x = y;
+   }
+}
+
+static digits_t gcd (digits_t a, digits_t b) {
+   while (not b.empty()) {
+      digits_t r = divide (a, b).second;
+      a = move (b);
+      b = move (r);
+   }
+   return a;
+}
+
+static string text_of (const decimal& a) {
+   if (a.digits.empty()) return "0";
+   string text = a.negative ? "_" : "";
+   for (size_t i = a.digits.size(); i-- > 0; ) {
+      text += '0' + a.digits[i];
+   }
+   return text;
+}
+
+static unsigned long to_long (const decimal& a) {
+   unsigned long n = 0;
+   for (size_t i = a.digits.size(); i-- > 0; ) n = n * 10 + a.digits[i];
+   return n;
+}
+
+//
+// The reference result of oper on operands, which are in the order
+// pushed, and so are the results.  The caller keeps the operands in
+// range:  no zero divisor or modulus, no negative root or factorial,
+// and an exponent that fits in a long.
+//
+static vector<decimal> evaluate (char oper,
+                                 const vector<decimal>& operands) {
+   const decimal& a = operands[0];
+   const decimal& b = operands.size() > 1 ? operands[1] : a;
+   switch (oper) {
+      case '+':
+         return {add (a, b)};
+      case '-':
+         return {add (a, negated (b))};
+      case '*':
+         return {with_sign (mul (a.digits, b.digits),
+                            a.negative != b.negative)};
+      case '/': case '%': case '~': {
+         auto qr = divide (a.digits, b.digits);
+         decimal quotient = with_sign (qr.first,
+                                       a.negative != b.negative);
+         decimal remainder = with_sign (qr.second, a.negative);
+         if (oper == '/') return {quotient};
+         if (oper == '%') return {remainder};
+         return {quotient, remainder};
+      }
+      case '^': {
+         unsigned long exponent = to_long (b);
+         return {with_sign (power (a.digits, exponent),
+                            a.negative and exponent % 2)};
+      }
+      case '|': {
+         const decimal& modulus = operands[2];
+         bool odd = not b.digits.empty() and b.digits[0] % 2;
+         return {with_sign (power_mod (a.digits, b.digits,
+                                       modulus.digits),
+                            a.negative and odd)};
+      }
+      case 'v':
+         return {with_sign (root (a.digits), false)};
+      case 'G':
+         return {with_sign (gcd (a.digits, b.digits), false)};
+      case 'F': {
+         digits_t product {1};
+         for (unsigned long i = 2; i <= to_long (a); ++i) {
+            product = mul (product, from_long (i));
+         }
+         return {with_sign (product, false)};
+      }
+   }
+   return {};
+}
+
+//
+// One case:  its script and the lines it should print.
+//
+struct fuzz_case {
+   string script;
+   vector<string> expected;
+};
+
+//
+// A chained program under construction:  its script so far, the
+// lines it has printed, and a model of the stack and registers.
+// Registers a and b hold numbers; m holds a macro and n a loop
+// count, whose values the model does not need, only how many there
+// are, so that the program can empty every register it used.
+//
+struct chain_state {
+   string script;
+   vector<string> printed;
+   vector<decimal> stack;
+   map<char, vector<decimal>> registers;
+};
+
+//
+// One step of a macro body, as its text and what it does to the
+// top of the stack.
+//
+struct macro_step {
+   string text;
+   function<decimal (const decimal&)> apply;
+};
+
+class generator {
+   private:
+      mt19937_64 random;
+      void push (chain_state& state, const decimal& value);
+      void operate (chain_state& state, char oper, size_t count);
+      macro_step make_step();
+      bool chain_step (chain_state& state);
+      bool chain_register (chain_state& state);
+      bool chain_macro (chain_state& state);
+   public:
+      explicit generator (unsigned long seed): random (seed) {}
+      size_t size (size_t most);
+      decimal number (size_t digits, bool may_be_negative);
+      fuzz_case make (char oper);
+      fuzz_case chain();
+};
+
+//
+// Digit counts are spread evenly over their logarithm, so small
+// and large operands both turn up.
+//
+size_t generator::size (size_t most) {
+   double scale = uniform_real_distribution<double> (0, log (most + 1))
+                  (random);
+   return min (most, max<size_t> (1, exp (scale)));
+}
+
+decimal generator::number (size_t digits, bool may_be_negative) {
+   decimal result;
+   for (size_t i = 0; i < digits; ++i) {
+      result.digits.push_back (random() % 10);
+   }
+   if (random() % 4 == 0) {
+      for (size_t i = 0; i < digits / 2; ++i) result.digits[i] = 0;
+   }
+   trim (result.digits);
+   result.negative = may_be_negative and random() % 2
+                     and not result.digits.empty();
+   return result;
+}
+
+fuzz_case generator::make (char oper) {
+   size_t most = max_digits;
+   decimal a = number (size (most), true);
+   decimal b = number (size (most), true);
+   vector<decimal> operands {a, b};
+   switch (oper) {
+      case '/': case '%': case '~':
+         while (b.digits.empty()) b = number (size (most), true);
+         operands[1] = b;
+         break;
+      case '^': {
+         size_t digits = size (most);
+         a = number (digits, true);
+         unsigned long exponent = random() % (most / digits + 2);
+         operands = {a, with_sign (from_long (exponent), false)};
+         break;
+      }
+      case '|': {
+         decimal e = number (size (min<size_t> (most, 40)), false);
+         size_t modulus = min<size_t> (most, 60);
+         b = number (size (modulus), true);
+         while (b.digits.empty()) b = number (size (modulus), true);
+         operands = {a, e, b};
+         break;
+      }
+      case 'v':
+         a.negative = false;
+         operands = {a};
+         break;
+      case 'F': {
+         unsigned long n = random() % min<size_t> (3 * most + 1, 1000);
+         operands = {with_sign (from_long (n), false)};
+         break;
+      }
+   }
+   vector<decimal> results = evaluate (oper, operands);
+   fuzz_case result;
+   for (const auto& operand: operands) {
+      result.script += text_of (operand) + " ";
+   }
+   result.script += string (1, oper) + " f c";
+   // Results are in the order pushed, and f prints the top first.
+   for (const auto& value: results) {
+      result.expected.insert (result.expected.begin(),
+                              text_of (value));
+   }
+   return result;
+}
+
+void generator::push (chain_state& state, const decimal& value) {
+   state.script += text_of (value) + " ";
+   state.stack.push_back (value);
+}
+
+//
+// Replace the top count values with the results of oper.
+//
+void generator::operate (chain_state& state, char oper, size_t count) {
+   vector<decimal> operands (state.stack.end() - count,
+                             state.stack.end());
+   state.stack.resize (state.stack.size() - count);
+   for (auto& value: evaluate (oper, operands)) {
+      state.stack.push_back (move (value));
+   }
+   state.script += string (1, oper) + " ";
+}
+
+//
+// A chained program:  a random run of pushes, arithmetic, d, p,
+// register moves, chains of + and - on one running value, and
+// macros run once, several times from a register, or as a counted
+// loop that calls itself last.  Long literals exercise deferred
+// parsing, and d and l make values that share limbs, which +, -
+// and * then change in place.  Operands stay under twice -d digits.
+// The program ends by printing the stack with f and emptying the
+// stack and every register it used, ready for the next one.
+//
+fuzz_case generator::chain() {
+   chain_state state;
+   size_t steps = 4 + random() % 20;
+   for (size_t done = 0, tries = 0; done < steps and tries < 1000;
+        ++tries) {
+      if (chain_step (state)) ++done;
+   }
+   fuzz_case result;
+   result.script = state.script + "f c";
+   result.expected = state.printed;
+   for (size_t i = state.stack.size(); i-- > 0; ) {
+      result.expected.push_back (text_of (state.stack[i]));
+   }
+   bool loaded = false;
+   for (const auto& reg: state.registers) {
+      for (size_t i = 0; i < reg.second.size(); ++i) {
+         result.script += string (" L") + reg.first;
+         loaded = true;
+      }
+   }
+   if (loaded) result.script += " c";
+   return result;
+}
+
+bool generator::chain_step (chain_state& state) {
+   size_t most = max_digits;
+   size_t limit = 2 * most;
+   vector<decimal>& stack = state.stack;
+   size_t depth = stack.size();
+   switch (random() % 12) {
+      case 0: case 1:
+         push (state, number (size (most), true));
+         return true;
+      case 2:
+         if (depth < 1) return false;
+         state.script += "d ";
+         stack.push_back (stack.back());
+         return true;
+      case 3: {
+         if (depth < 2) return false;
+         const decimal& a = stack[depth - 2];
+         const decimal& b = stack[depth - 1];
+         static const string opers = "+-*G/%~";
+         char oper = opers[random() % opers.size()];
+         size_t digits = a.digits.size() + b.digits.size();
+         if (oper == '*' and digits > limit) return false;
+         if (opers.find (oper) > 3 and b.digits.empty()) return false;
+         operate (state, oper, 2);
+         return true;
+      }
+      case 4: {
+         if (depth < 1 or stack.back().digits.size() > most) {
+            return false;
+         }
+         size_t digits = max<size_t> (1, stack.back().digits.size());
+         unsigned long exponent = random() % (limit / digits + 1);
+         push (state, with_sign (from_long (exponent), false));
+         operate (state, '^', 2);
+         return true;
+      }
+      case 5:
+         if (depth < 1 or stack.back().negative) return false;
+         operate (state, 'v', 1);
+         return true;
+      case 6: {
+         if (depth < 1) return false;
+         decimal modulus = number (size (min<size_t> (most, 60)), true);
+         if (modulus.digits.empty()) return false;
+         push (state, number (size (min<size_t> (most, 40)), false));
+         push (state, modulus);
+         operate (state, '|', 3);
+         return true;
+      }
+      case 7:
+         return chain_register (state);
+      case 8: {
+         if (depth < 1) return false;
+         size_t terms = 2 + random() % 7;
+         for (size_t i = 0; i < terms; ++i) {
+            push (state, number (size (most), true));
+            operate (state, random() % 2 ? '+' : '-', 2);
+         }
+         return true;
+      }
+      case 9: case 10:
+         return chain_macro (state);
+      case 11:
+         if (depth < 1) return false;
+         state.script += "p ";
+         state.printed.push_back (text_of (stack.back()));
+         return true;
+   }
+   return false;
+}
+
+//
+// s, S, l or L on register a or b.
+//
+bool generator::chain_register (chain_state& state) {
+   char reg = random() % 2 ? 'a' : 'b';
+   vector<decimal>& values = state.registers[reg];
+   vector<decimal>& stack = state.stack;
+   char oper = "sSlL"[random() % 4];
+   switch (oper) {
+      case 's': case 'S':
+         if (stack.empty()) return false;
+         if (oper == 's' and not values.empty()) values.pop_back();
+         values.push_back (stack.back());
+         stack.pop_back();
+         break;
+      case 'l':
+         if (values.empty()) return false;
+         stack.push_back (values.back());
+         break;
+      case 'L':
+         if (values.empty()) return false;
+         stack.push_back (values.back());
+         values.pop_back();
+         break;
+   }
+   state.script += string (1, oper) + reg + " ";
+   return true;
+}
+
+macro_step generator::make_step() {
+   size_t most = max_digits;
+   decimal constant = number (size (min<size_t> (most, 3)), true);
+   switch (random() % 6) {
+      case 0:
+         return {"d *", [](const decimal& top) {
+            return evaluate ('*', {top, top})[0];
+         }};
+      case 1:
+         return {"d +", [](const decimal& top) {
+            return evaluate ('+', {top, top})[0];
+         }};
+      case 2:
+         constant = number (size (most), true);
+         return {text_of (constant) + " +",
+                 [constant] (const decimal& top) {
+                    return evaluate ('+', {top, constant})[0];
+                 }};
+      case 3:
+         constant = number (size (most), true);
+         return {text_of (constant) + " -",
+                 [constant] (const decimal& top) {
+                    return evaluate ('-', {top, constant})[0];
+                 }};
+      case 4:
+         return {text_of (constant) + " *",
+                 [constant] (const decimal& top) {
+                    return evaluate ('*', {top, constant})[0];
+                 }};
+      default:
+         constant = number (size (most), true);
+         if (constant.digits.empty()) constant.digits = {7};
+         return {text_of (constant) + " %",
+                 [constant] (const decimal& top) {
+                    return evaluate ('%', {top, constant})[0];
+                 }};
+   }
+}
+
+//
+// A macro of one to three steps on the top of the stack, run as
+// [body]x, or stored in m and run several times with lmx, or as
+//    count sn [body ln 1 - d sn 0 <m] d sm x
+// which runs body count times, calling itself last.  The steps are
+// tried on the model first, and the macro given up if they would
+// grow the value past the limit.
+//
+bool generator::chain_macro (chain_state& state) {
+   if (state.stack.empty()) return false;
+   vector<macro_step> body (1 + random() % 3);
+   for (auto& step: body) step = make_step();
+   int form = random() % 3;
+   size_t times = form == 0 ? 1 : 1 + random() % 5;
+   decimal top = state.stack.back();
+   for (size_t i = 0; i < times; ++i) {
+      for (const auto& step: body) {
+         top = step.apply (top);
+         if (top.digits.size() > 2 * max_digits) return false;
+      }
+   }
+   string text;
+   for (const auto& step: body) text += step.text + " ";
+   state.stack.back() = top;
+   switch (form) {
+      case 0:
+         state.script += "[" + text + "]x ";
+         break;
+      case 1:
+         state.script += "[" + text + "]sm";
+         for (size_t i = 0; i < times; ++i) state.script += " lmx";
+         state.script += " ";
+         state.registers['m'] = {decimal()};
+         break;
+      case 2:
+         state.script += to_string (times) + " sn [" + text
+                       + "ln 1 - d sn 0 <m] d sm x ";
+         state.registers['m'] = {decimal()};
+         state.registers['n'] = {decimal()};
+         break;
+   }
+   return true;
+}
+
+//
+// Run ydc on script and return its output lines.
+//
+static vector<string> run_ydc (const string& ydc,
+                               const string& script) {
+   const char* tmpdir = getenv ("TMPDIR");
+   string pattern = tmpdir != nullptr and *tmpdir != '\0' ? tmpdir
+                                                          : "/tmp";
+   pattern += "/ydcfuzz.XXXXXX";
+   vector<char> filename (pattern.begin(), pattern.end());
+   filename.push_back ('\0');
+   int fd = mkstemp (filename.data());
+   vector<string> lines;
+   if (fd < 0) {
+      complain() << pattern << ": cannot create" << endl;
+      return lines;
+   }
+   close (fd);
+   ofstream (filename.data()) << script;
+   string command = ydc + " " + ydc_args + " " + filename.data();
+   FILE* pipe = popen (command.c_str(), "r");
+   if (pipe == nullptr) {
+      complain() << command << ": cannot run" << endl;
+   }else {
+      string line;
+      for (int ch; (ch = getc (pipe)) != EOF; ) {
+         if (ch != '\n') {
+            line += ch;
+            continue;
+         }
+         lines.push_back (line);
+         line.clear();
+      }
+      if (not line.empty()) lines.push_back (line);
+      pclose (pipe);
+   }
+   unlink (filename.data());
+   return lines;
+}
+
+static double seconds (steady::duration time) {
+   return chrono::duration<double> (time).count();
+}
+
+//
+// The least of three runs of ydc on an empty script, taken off each
+// operator's time so that small operands do not just time startup.
+//
+static double startup_seconds (const string& ydc) {
+   double least = 0;
+   for (int run = 0; run < 3; ++run) {
+      steady::time_point start = steady::now();
+      run_ydc (ydc, "");
+      double elapsed = seconds (steady::now() - start);
+      least = run == 0 ? elapsed : min (least, elapsed);
+   }
+   return least;
+}
+
+static void fuzz (const string& ydc, char oper, generator& random,
+                  double startup) {
+   steady::time_point start = steady::now();
+   vector<fuzz_case> tests;
+   string script;
+   for (size_t i = 0; i < cases; ++i) {
+      tests.push_back (oper == 'P' ? random.chain()
+                                   : random.make (oper));
+      script += tests.back().script + "\n";
+   }
+   double oracle_seconds = seconds (steady::now() - start);
+   start = steady::now();
+   vector<string> output = run_ydc (ydc, script);
+   double ydc_seconds = max (seconds (steady::now() - start) - startup,
+                             1e-6);
+   size_t mismatches = 0;
+   size_t line = 0;
+   for (const auto& test: tests) {
+      bool match = true;
+      string actual;
+      for (const auto& expected: test.expected) {
+         string got = line < output.size() ? output[line] : "(none)";
+         ++line;
+         actual += got + " ";
+         if (got != expected) match = false;
+      }
+      if (match) continue;
+      ++mismatches;
+      complain() << "mismatch: " << test.script << endl
+                 << "   ydc: " << actual << endl << "   expected:";
+      for (const auto& expected: test.expected) cerr << " " << expected;
+      cerr << endl;
+   }
+   if (line < output.size()) {
+      complain() << oper << ": " << output.size() - line
+                 << " extra lines of output" << endl;
+   }
+   cout << "{\"op\": \"" << oper << "\", \"cases\": " << cases
+        << ", \"max_digits\": " << max_digits
+        << ", \"mismatches\": " << mismatches
+        << ", \"ydc_seconds\": " << ydc_seconds
+        << ", \"startup_seconds\": " << startup
+        << ", \"oracle_seconds\": " << oracle_seconds
+        << ", \"speedup\": " << oracle_seconds / ydc_seconds
+        << "}" << endl;
+}
+
+static bool parse_count (const char* text, unsigned long& count) {
+   char* end = nullptr;
+   count = strtoul (text, &end, 10);
+   return *text != '\0' and *end == '\0' and count > 0;
+}
+
+void scan_options (int argc, char** argv) {
+   opterr = 0;
+   for (;;) {
+      int option = getopt (argc, argv, "a:d:n:o:s:");
+      if (option == EOF) break;
+      unsigned long count = 0;
+      bool valid = true;
+      switch (option) {
+         case 'a':
+            ydc_args = optarg;
+            break;
+         case 'd':
+            valid = parse_count (optarg, count);
+            if (valid) max_digits = count;
+            break;
+         case 'n':
+            valid = parse_count (optarg, count);
+            if (valid) cases = count;
+            break;
+         case 'o':
+            operators = optarg;
+            valid = operators.find_first_not_of ("+-*/%~^|vGFP")
+                    == string::npos;
+            break;
+         case 's':
+            valid = parse_count (optarg, seed);
+            break;
+         default:
+            complain() << "-" << (char) optopt << ": invalid option"
+                       << endl;
+            continue;
+      }
+      if (not valid) {
+         complain() << "-" << (char) option << " " << optarg
+                    << ": invalid value" << endl;
+      }
+   }
+}
+
+int main (int argc, char** argv) {
+   sys_info::execname (argv[0]);
+   scan_options (argc, argv);
+   if (optind + 1 != argc) {
+      complain() << "Usage: " << sys_info::execname()
+                 << " [-a args] [-d digits] [-n cases] [-o ops]"
+                 << " [-s seed] ydc" << endl;
+   }
+   if (sys_info::status() != EXIT_SUCCESS) return sys_info::status();
+   generator random (seed);
+   double startup = startup_seconds (argv[optind]);
+   for (char oper: operators) {
+      fuzz (argv[optind], oper, random, startup);
+   }
+   return sys_info::status();
+}
@@ -22,6 +22,7 @@
 #ifndef __ITERSTACK_H__
 #define __ITERSTACK_H__
 
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -42,8 +43,10 @@ class iterstack: private vector<value_type> {
       inline const_iterator begin() {return crbegin();}
       inline const_iterator end() {return crend();}
       inline void push (const value_type& value) {push_back (value);}
+      inline void push (value_type&& value) {push_back (move (value));}
       inline void pop() {pop_back();}
       inline const value_type& top() const {return back();}
+      inline value_type& top() {return back();}
 };
 
 #endif
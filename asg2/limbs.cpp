@@ -0,0 +1,322 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+#include <atomic>
+#include <cstring>
+#include <utility>
+using namespace std;
+
+#if defined (__x86_64__) or defined (__i386__)
+#include <immintrin.h>
+#define LIMBS_AVX2
+#endif
+
+#include "limbs.h"
+
+#ifdef LIMBS_AVX2
+
+//
+// AVX2 kernels for the first n limbs of add and sub, n a multiple
+// of 8.  Each block of eight limbs is added lane by lane, the lanes
+// at or over the radix are reduced, and their carries are shifted up
+// one lane and added in, with the carry from the previous block
+// entering lane 0.  That is exact unless a lane that was radix - 1
+// receives a carry, which needs the carry to ripple; the rare block
+// where that happens is redone with the scalar loop.  Limbs are
+// below 2^30, so signed compares are safe.  Each block is loaded
+// before it is stored, so r may be the same array as a or b.
+//
+
+static bool has_avx2() {
+   static const bool supported = []() {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports ("avx2") != 0;
+   }();
+   return supported;
+}
+
+static const size_t simd_min = 16;
+
+__attribute__ ((target ("avx2")))
+static limb_t add_n_avx2 (limb_t* r, const limb_t* a, const limb_t* b,
+                          size_t n) {
+   const __m256i radix = _mm256_set1_epi32 (limb_radix);
+   const __m256i top = _mm256_set1_epi32 (limb_radix - 1);
+   const __m256i rotate = _mm256_setr_epi32 (7, 0, 1, 2, 3, 4, 5, 6);
+   limb_t carry = 0;
+   for (size_t i = 0; i < n; i += 8) {
+      __m256i x = _mm256_loadu_si256 ((const __m256i*) (a + i));
+      __m256i y = _mm256_loadu_si256 ((const __m256i*) (b + i));
+      __m256i sum = _mm256_add_epi32 (x, y);
+      __m256i over = _mm256_cmpgt_epi32 (sum, top);
+      sum = _mm256_sub_epi32 (sum, _mm256_and_si256 (over, radix));
+      __m256i carries = _mm256_permutevar8x32_epi32 (over, rotate);
+      carries = _mm256_blend_epi32 (carries,
+                _mm256_set1_epi32 (- int32_t (carry)), 1);
+      sum = _mm256_sub_epi32 (sum, carries);
+      __m256i ripple = _mm256_cmpeq_epi32 (sum, radix);
+      if (_mm256_testz_si256 (ripple, ripple)) {
+         _mm256_storeu_si256 ((__m256i*) (r + i), sum);
+         carry = _mm256_extract_epi32 (over, 7) & 1;
+         continue;
+      }
+      for (size_t j = i; j < i + 8; ++j) {
+         limb_t digit = a[j] + b[j] + carry;
+         carry = digit >= limb_radix;
+         r[j] = carry ? digit - limb_radix : digit;
+      }
+   }
+   return carry;
+}
+
+__attribute__ ((target ("avx2")))
+static limb_t sub_n_avx2 (limb_t* r, const limb_t* a, const limb_t* b,
+                          size_t n) {
+   const __m256i radix = _mm256_set1_epi32 (limb_radix);
+   const __m256i ones = _mm256_set1_epi32 (-1);
+   const __m256i rotate = _mm256_setr_epi32 (7, 0, 1, 2, 3, 4, 5, 6);
+   limb_t borrow = 0;
+   for (size_t i = 0; i < n; i += 8) {
+      __m256i x = _mm256_loadu_si256 ((const __m256i*) (a + i));
+      __m256i y = _mm256_loadu_si256 ((const __m256i*) (b + i));
+      __m256i under = _mm256_cmpgt_epi32 (y, x);
+      __m256i diff = _mm256_sub_epi32 (x, y);
+      diff = _mm256_add_epi32 (diff, _mm256_and_si256 (under, radix));
+      __m256i borrows = _mm256_permutevar8x32_epi32 (under, rotate);
+      borrows = _mm256_blend_epi32 (borrows,
+                _mm256_set1_epi32 (- int32_t (borrow)), 1);
+      diff = _mm256_add_epi32 (diff, borrows);
+      __m256i ripple = _mm256_cmpeq_epi32 (diff, ones);
+      if (_mm256_testz_si256 (ripple, ripple)) {
+         _mm256_storeu_si256 ((__m256i*) (r + i), diff);
+         borrow = _mm256_extract_epi32 (under, 7) & 1;
+         continue;
+      }
+      for (size_t j = i; j < i + 8; ++j) {
+         limb_t subtrahend = b[j] + borrow;
+         borrow = a[j] < subtrahend;
+         r[j] = a[j] + (borrow ? limb_radix : 0) - subtrahend;
+      }
+   }
+   return borrow;
+}
+
+#endif
+
+//
+// The scratch pool.  Class c holds blocks of 2^c limbs; each thread
+// keeps up to scratch_keep free blocks of each class it has used,
+// and no more than scratch_keep_bytes in all, so that every -j
+// worker does not sit on a large block of each size.
+//
+static const int scratch_min_class = 4;
+static const int scratch_max_class = 20;
+static const size_t scratch_keep = 32;
+static const size_t scratch_keep_bytes = size_t (8) << 20;
+
+struct scratch_pool {
+   vector<limb_t*> free[scratch_max_class + 1];
+   size_t kept_bytes {0};
+   ~scratch_pool() {
+      for (auto& blocks: free) {
+         for (limb_t* block: blocks) delete[] block;
+      }
+   }
+};
+
+static thread_local scratch_pool scratch_blocks;
+static atomic<size_t> scratch_in_use {0};
+static atomic<size_t> scratch_peak {0};
+
+limb_scratch::limb_scratch (size_t count): count (count) {
+   if (count == 0) return;
+   size_class = scratch_min_class;
+   while (size_t (1) << size_class < count) ++size_class;
+   size_t bytes = sizeof (limb_t) << size_class;
+   if (size_class <= scratch_max_class
+       and not scratch_blocks.free[size_class].empty()) {
+      limbs = scratch_blocks.free[size_class].back();
+      scratch_blocks.free[size_class].pop_back();
+      scratch_blocks.kept_bytes -= bytes;
+   }else {
+      limbs = new limb_t[size_t (1) << size_class];
+   }
+   memset (limbs, 0, count * sizeof *limbs);
+   size_t in_use = scratch_in_use.fetch_add (bytes) + bytes;
+   size_t peak = scratch_peak.load();
+   while (peak < in_use
+          and not scratch_peak.compare_exchange_weak (peak, in_use)) {
+   }
+}
+
+limb_scratch::limb_scratch (limb_scratch&& that) noexcept:
+            limbs (that.limbs), count (that.count),
+            size_class (that.size_class) {
+   that.limbs = nullptr;
+   that.count = 0;
+}
+
+limb_scratch& limb_scratch::operator= (limb_scratch&& that) noexcept {
+   swap (limbs, that.limbs);
+   swap (count, that.count);
+   swap (size_class, that.size_class);
+   return *this;
+}
+
+limb_scratch::~limb_scratch() {
+   if (limbs == nullptr) return;
+   size_t bytes = sizeof (limb_t) << size_class;
+   scratch_in_use.fetch_sub (bytes);
+   if (size_class <= scratch_max_class
+       and scratch_blocks.free[size_class].size() < scratch_keep
+       and scratch_blocks.kept_bytes + bytes <= scratch_keep_bytes) {
+      scratch_blocks.free[size_class].push_back (limbs);
+      scratch_blocks.kept_bytes += bytes;
+   }else {
+      delete[] limbs;
+   }
+}
+
+size_t limb_scratch::peak_bytes() {
+   return scratch_peak.load();
+}
+
+void limb_scratch::reset_peak() {
+   scratch_peak.store (scratch_in_use.load());
+}
+
+size_t limbs_trim (const limb_t* a, size_t an) {
+   while (an > 0 and a[an - 1] == 0) --an;
+   return an;
+}
+
+int limbs_cmp (const limb_t* a, size_t an, const limb_t* b, size_t bn) {
+   an = limbs_trim (a, an);
+   bn = limbs_trim (b, bn);
+   if (an != bn) return an < bn ? -1 : 1;
+   for (size_t i = an; i-- > 0; ) {
+      if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+   }
+   return 0;
+}
+
+limb_t limbs_add (limb_t* r, const limb_t* a, size_t an,
+                  const limb_t* b, size_t bn) {
+   limb_t carry = 0;
+   size_t i = 0;
+#ifdef LIMBS_AVX2
+   if (bn >= simd_min and has_avx2()) {
+      i = bn / 8 * 8;
+      carry = add_n_avx2 (r, a, b, i);
+   }
+#endif
+   for (; i < bn; ++i) {
+      limb_t sum = a[i] + b[i] + carry;
+      carry = sum >= limb_radix;
+      r[i] = carry ? sum - limb_radix : sum;
+   }
+   for (; carry and i < an; ++i) {
+      limb_t sum = a[i] + 1;
+      carry = sum == limb_radix;
+      r[i] = carry ? 0 : sum;
+   }
+   if (r != a and i < an) memcpy (r + i, a + i, (an - i) * sizeof *r);
+   return carry;
+}
+
+limb_t limbs_sub (limb_t* r, const limb_t* a, size_t an,
+                  const limb_t* b, size_t bn) {
+   limb_t borrow = 0;
+   size_t i = 0;
+#ifdef LIMBS_AVX2
+   if (bn >= simd_min and has_avx2()) {
+      i = bn / 8 * 8;
+      borrow = sub_n_avx2 (r, a, b, i);
+   }
+#endif
+   for (; i < bn; ++i) {
+      limb_t subtrahend = b[i] + borrow;
+      borrow = a[i] < subtrahend;
+      r[i] = a[i] + (borrow ? limb_radix : 0) - subtrahend;
+   }
+   for (; borrow and i < an; ++i) {
+      borrow = a[i] == 0;
+      r[i] = borrow ? limb_radix - 1 : a[i] - 1;
+   }
+   if (r != a and i < an) memcpy (r + i, a + i, (an - i) * sizeof *r);
+   return borrow;
+}
+
+limb_t limbs_mul_1 (limb_t* r, const limb_t* a, size_t an, limb_t m) {
+   dlimb_t carry = 0;
+   for (size_t i = 0; i < an; ++i) {
+      dlimb_t product = dlimb_t (a[i]) * m + carry;
+      r[i] = product % limb_radix;
+      carry = product / limb_radix;
+   }
+   return carry;
+}
+
+limb_t limbs_addmul_1 (limb_t* r, const limb_t* a, size_t an,
+                       limb_t m) {
+   dlimb_t carry = 0;
+   for (size_t i = 0; i < an; ++i) {
+      dlimb_t sum = r[i] + dlimb_t (a[i]) * m + carry;
+      r[i] = sum % limb_radix;
+      carry = sum / limb_radix;
+   }
+   return carry;
+}
+
+limb_t limbs_divrem_1 (limb_t* q, const limb_t* a, size_t an,
+                       limb_t d) {
+   dlimb_t remainder = 0;
+   for (size_t i = an; i-- > 0; ) {
+      dlimb_t dividend = remainder * limb_radix + a[i];
+      q[i] = dividend / d;
+      remainder = dividend % d;
+   }
+   return remainder;
+}
+
+void limbs_mul_basecase (limb_t* r, const limb_t* a, size_t an,
+                         const limb_t* b, size_t bn) {
+   memset (r, 0, (an + bn) * sizeof *r);
+   for (size_t i = 0; i < an; ++i) {
+      dlimb_t multiplier = a[i];
+      if (multiplier == 0) continue;
+      dlimb_t carry = 0;
+      for (size_t j = 0; j < bn; ++j) {
+         dlimb_t d = r[i + j] + multiplier * b[j] + carry;
+         r[i + j] = d % limb_radix;
+         carry = d / limb_radix;
+      }
+      r[i + bn] = carry;
+   }
+}
+
+void limbs_sqr_basecase (limb_t* r, const limb_t* a, size_t an) {
+   memset (r, 0, 2 * an * sizeof *r);
+   for (size_t i = 0; i < an; ++i) {
+      dlimb_t multiplier = a[i];
+      if (multiplier == 0) continue;
+      dlimb_t carry = 0;
+      for (size_t j = i + 1; j < an; ++j) {
+         dlimb_t d = r[i + j] + multiplier * a[j] + carry;
+         r[i + j] = d % limb_radix;
+         carry = d / limb_radix;
+      }
+      r[i + an] = carry;
+   }
+   limbs_mul_1 (r, r, 2 * an, 2);
+   dlimb_t carry = 0;
+   for (size_t i = 0; i < an; ++i) {
+      dlimb_t square = dlimb_t (a[i]) * a[i];
+      dlimb_t lo = r[2 * i] + square % limb_radix + carry;
+      r[2 * i] = lo % limb_radix;
+      dlimb_t hi = r[2 * i + 1] + square / limb_radix + lo / limb_radix;
+      r[2 * i + 1] = hi % limb_radix;
+      carry = hi / limb_radix;
+   }
+}
+
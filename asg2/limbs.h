@@ -0,0 +1,180 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// limbs -
+//    Unsigned magnitude kernels used by bigint.  A magnitude is a
+//    little-endian array of limbs, each one holding limb_digits
+//    decimal digits.  The caller sizes every output array.  Unless
+//    noted, an output may be the same array as the first input but
+//    may not otherwise overlap an input.
+//
+
+#ifndef __LIMBS_H__
+#define __LIMBS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+using limb_t = uint32_t;
+using dlimb_t = uint64_t; // Holds a limb product plus two limbs.
+using limbvec = vector<limb_t>;
+
+const limb_t limb_radix = 1000000000;
+const int limb_digits = 9;
+
+//
+// bigtuning -
+//    Operand sizes, in limbs, at which multiplication and division
+//    switch to the next algorithm, and at which multiplication
+//    starts splitting its work across threads.  The defaults suit a
+//    typical x86-64 box; ydc -T can override them by name.  threads
+//    is the total number of threads multiplication may use, set by
+//    ydc -j.
+//
+
+class bigtuning {
+   public:
+      static size_t karatsuba_threshold;
+      static size_t toom3_threshold;
+      static size_t ntt_threshold;
+      static size_t bz_threshold;
+      static size_t parallel_threshold;
+      static size_t threads;
+      static bool set (const string& name, size_t value);
+};
+
+//
+// limb_scratch -
+//    A temporary limb array for the kernels, zeroed like a limbvec,
+//    taken from a per-thread pool of power-of-two size classes and
+//    given back when it goes out of scope.  The repeated temporaries
+//    of a division or exponentiation then reuse a few blocks rather
+//    than going to the heap each time.  Blocks above a few megabytes
+//    are not kept, since the work on them dwarfs the allocation, and
+//    each thread keeps at most 8 MB of free blocks.
+//    peak_bytes is the most held at once, across all threads, since
+//    reset_peak.
+//
+
+class limb_scratch {
+   private:
+      limb_t* limbs {nullptr};
+      size_t count {0};
+      int size_class {0};
+   public:
+      explicit limb_scratch (size_t count = 0);
+      limb_scratch (limb_scratch&& that) noexcept;
+      limb_scratch& operator= (limb_scratch&& that) noexcept;
+      limb_scratch (const limb_scratch&) = delete;
+      limb_scratch& operator= (const limb_scratch&) = delete;
+      ~limb_scratch();
+      limb_t* data() { return limbs; }
+      const limb_t* data() const { return limbs; }
+      size_t size() const { return count; }
+      limb_t& operator[] (size_t i) { return limbs[i]; }
+      const limb_t& operator[] (size_t i) const { return limbs[i]; }
+      limb_t* begin() { return limbs; }
+      limb_t* end() { return limbs + count; }
+      static size_t peak_bytes();
+      static void reset_peak();
+};
+
+//
+// Length of a with leading zero limbs dropped.
+//
+size_t limbs_trim (const limb_t* a, size_t an);
+
+//
+// Compare two magnitudes, ignoring leading zeros.  Returns a
+// negative, zero, or positive number as a is less than, equal to,
+// or greater than b.
+//
+int limbs_cmp (const limb_t* a, size_t an, const limb_t* b, size_t bn);
+
+//
+// r[0..an) = a + b, where an >= bn.  Returns the carry out.  Since
+// the limbs are visited in order, r may be the same array as b.
+//
+limb_t limbs_add (limb_t* r, const limb_t* a, size_t an,
+                  const limb_t* b, size_t bn);
+
+//
+// r[0..an) = a - b, where an >= bn.  Returns the borrow out,
+// which is nonzero only if b > a.  r may be the same array as b.
+//
+limb_t limbs_sub (limb_t* r, const limb_t* a, size_t an,
+                  const limb_t* b, size_t bn);
+
+//
+// r[0..an) = a * m.  Returns the carry out.
+//
+limb_t limbs_mul_1 (limb_t* r, const limb_t* a, size_t an, limb_t m);
+
+//
+// r[0..an) += a * m.  Returns the carry out.
+//
+limb_t limbs_addmul_1 (limb_t* r, const limb_t* a, size_t an, limb_t m);
+
+//
+// q[0..an) = a / d.  Returns the remainder.
+//
+limb_t limbs_divrem_1 (limb_t* q, const limb_t* a, size_t an,
+                       limb_t d);
+
+//
+// q[0..an-bn] = a / b and r[0..bn) = a % b, where an >= bn and the
+// top limb of b is nonzero.
+//
+void limbs_divrem (limb_t* q, limb_t* r, const limb_t* a, size_t an,
+                   const limb_t* b, size_t bn);
+
+//
+// r[0..an+bn) = a * b by the schoolbook method.
+//
+void limbs_mul_basecase (limb_t* r, const limb_t* a, size_t an,
+                         const limb_t* b, size_t bn);
+
+//
+// r[0..2an) = a * a by the schoolbook method, computing each cross
+// product once.
+//
+void limbs_sqr_basecase (limb_t* r, const limb_t* a, size_t an);
+
+//
+// r[0..an+bn) = a * b by number-theoretic transform.  an + bn may
+// not exceed limbs_mul_ntt_limit().
+//
+void limbs_mul_ntt (limb_t* r, const limb_t* a, size_t an,
+                    const limb_t* b, size_t bn);
+size_t limbs_mul_ntt_limit();
+
+//
+// r[0..an+bn) = a * b, choosing the algorithm by operand size.
+// Either length may be zero.  r may not overlap a or b.
+//
+void limbs_mul (limb_t* r, const limb_t* a, size_t an,
+                const limb_t* b, size_t bn);
+
+//
+// r[0..2an) = a * a.  Squaring is recognized by limbs_mul whenever
+// both operands are the same array, and every algorithm then saves
+// the work of handling the second operand.
+//
+inline void limbs_sqr (limb_t* r, const limb_t* a, size_t an) {
+   limbs_mul (r, a, an, a, an);
+}
+
+//
+// r[0..mn) = base^e mod m, where base < m and the top limb of m is
+// nonzero.  Works in Montgomery form when m is coprime to the radix.
+//
+void limbs_powmod (limb_t* r, const limb_t* base, size_t basen,
+                   const limb_t* e, size_t en,
+                   const limb_t* m, size_t mn);
+
+#endif
+
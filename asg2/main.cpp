@@ -1,158 +1,669 @@
 //Brandon Jarvinen (bjarvine@ucsc.edu)
 //Fan Zhang (fzhang12@ucsc.edu)
 
-#include <deque>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
 #include <iostream>
-#include <map>
+#include <memory>
 #include <stdexcept>
+#include <thread>
 #include <utility>
+#include <vector>
 using namespace std;
 
 #include <unistd.h>
 
 #include "bigint.h"
+#include "checkpoint.h"
 #include "debug.h"
 #include "iterstack.h"
+#include "limbs.h"
+#include "program.h"
 #include "scanner.h"
+#include "spscqueue.h"
+#include "stats.h"
 #include "util.h"
 
-using bigint_stack = iterstack<bigint>;
+static bool pipelined = false;
+static string checkpoint_file = "ydc.ckpt";
+static size_t line_width = 0;
 
-void do_arith (bigint_stack& stack, const char oper) {
-   if (stack.size() < 2) throw ydc_exn ("stack empty");
-   bigint right = stack.top();
+//
+// Check that the top count values are numbers before any is popped,
+// so that a command short of operands leaves the stack as it was.
+//
+void need_numbers (ydc_stack& stack, size_t count) {
+   if (stack.size() < count) throw ydc_exn ("stack empty");
+   size_t checked = 0;
+   for (const auto& value: stack) {
+      if (checked++ == count) break;
+      if (value.is_macro()) throw ydc_exn ("non-numeric value");
+   }
+}
+
+bigint pop_number (ydc_stack& stack) {
+   bigint number = move (stack.top().number);
    stack.pop();
+   return number;
+}
+
+//
+// Operands are moved off the stack and the result is computed into
+// the left one and moved back, so +, -, and * on values that keep
+// their size reuse the left operand's limbs instead of allocating.
+// An operation that throws has not changed its operands, and they
+// are pushed back, so that as in dc a failed command such as
+// division by zero leaves the stack as it was.
+//
+void do_arith (ydc_stack& stack, const char oper) {
+   need_numbers (stack, 2);
+   bigint right = pop_number (stack);
    DEBUGF ('d', "right = " << right);
-   bigint left = stack.top();
-   stack.pop();
+   bigint left = pop_number (stack);
    DEBUGF ('d', "left = " << left);
+   try {
+      switch (oper) {
+         case '+': left += right; break;
+         case '-': left -= right; break;
+         case '*': left *= right; break;
+         case '/': left /= right; break;
+         case '%': left %= right; break;
+         case '^': left = pow (left, right); break;
+         case 'G': left = gcd (left, right); break;
+         default: throw invalid_argument (
+                        string ("do_arith operator is ") + oper);
+      }
+   }catch (...) {
+      stack.push (move (left));
+      stack.push (move (right));
+      throw;
+   }
+   DEBUGF ('d', "result = " << left);
+   stack.push (move (left));
+}
+
+void do_unary (ydc_stack& stack, const char oper) {
+   need_numbers (stack, 1);
+   bigint operand = pop_number (stack);
+   DEBUGF ('d', "operand = " << operand);
    bigint result;
-   switch (oper) {
-      case '+': result = left + right; break;
-      case '-': result = left - right; break;
-      case '*': result = left * right; break;
-      case '/': result = left / right; break;
-      case '%': result = left % right; break;
-      case '^': result = pow (left, right); break;
-      default: throw invalid_argument (
-                     string ("do_arith operator is ") + oper);
+   try {
+      switch (oper) {
+         case 'v': result = isqrt (operand); break;
+         case 'F': result = factorial (operand); break;
+         default: throw invalid_argument (
+                        string ("do_unary operator is ") + oper);
+      }
+   }catch (...) {
+      stack.push (move (operand));
+      throw;
    }
    DEBUGF ('d', "result = " << result);
-   stack.push (result);
+   stack.push (move (result));
 }
 
-void do_clear (bigint_stack& stack, const char) {
+void do_powmod (ydc_stack& stack, const char) {
+   need_numbers (stack, 3);
+   bigint modulus = pop_number (stack);
+   bigint exponent = pop_number (stack);
+   bigint base = pop_number (stack);
+   bigint result;
+   try {
+      result = pow_mod (base, exponent, modulus);
+   }catch (...) {
+      stack.push (move (base));
+      stack.push (move (exponent));
+      stack.push (move (modulus));
+      throw;
+   }
+   DEBUGF ('d', "result = " << result);
+   stack.push (move (result));
+}
+
+void do_divrem (ydc_stack& stack, const char) {
+   need_numbers (stack, 2);
+   bigint right = pop_number (stack);
+   bigint left = pop_number (stack);
+   bigint::quot_rem result;
+   try {
+      result = divide (left, right);
+   }catch (...) {
+      stack.push (move (left));
+      stack.push (move (right));
+      throw;
+   }
+   DEBUGF ('d', "quotient = " << result.first
+                << ", remainder = " << result.second);
+   stack.push (move (result.first));
+   stack.push (move (result.second));
+}
+
+void do_clear (ydc_stack& stack, const char) {
    DEBUGF ('d', "");
    stack.clear();
 }
 
-void do_dup (bigint_stack& stack, const char) {
-   bigint top = stack.top();
+void do_dup (ydc_stack& stack, const char) {
+   if (stack.empty()) throw ydc_exn ("stack empty");
+   ydc_value top = stack.top();
    DEBUGF ('d', top);
-   stack.push (top);
+   stack.push (move (top));
 }
 
 
-void do_printall (bigint_stack& stack, const char) {
-   for (const auto &elem: stack) cout << elem << endl;
+//
+// Print one value on its own line, a number broken at -w columns.
+//
+void print_value (const ydc_value& value) {
+   if (value.is_macro()) cout << value;
+                    else print (cout, value.number, line_width);
+   cout << endl;
+}
+
+void do_printall (ydc_stack& stack, const char) {
+   for (const auto &elem: stack) print_value (elem);
+}
+
+void do_print (ydc_stack& stack, const char) {
+   if (stack.empty()) throw ydc_exn ("stack empty");
+   print_value (stack.top());
+}
+
+void do_save (ydc_stack& stack, const char) {
+   save_stack (checkpoint_file, stack);
 }
 
-void do_print (bigint_stack& stack, const char) {
-   cout << stack.top() << endl;
+void do_restore (ydc_stack& stack, const char) {
+   restore_stack (checkpoint_file, stack);
 }
 
-void do_debug (bigint_stack& stack, const char) {
+void do_debug (ydc_stack& stack, const char) {
    (void) stack; // SUPPRESS: warning: unused parameter 'stack'
    cout << "Y not implemented" << endl;
 }
 
 class ydc_quit: public exception {};
-void do_quit (bigint_stack&, const char) {
-   throw ydc_quit();
-}
-
-using function_t = void (*)(bigint_stack&, const char);
-using fn_map = map<string,function_t>;
-fn_map do_functions = {
-   {"+", do_arith},
-   {"-", do_arith},
-   {"*", do_arith},
-   {"/", do_arith},
-   {"%", do_arith},
-   {"^", do_arith},
-   {"Y", do_debug},
-   {"c", do_clear},
-   {"d", do_dup},
-   {"f", do_printall},
-   {"p", do_print},
-   {"q", do_quit},
+
+//
+// Commands without a register, indexed by their character.  The
+// commands that work on registers or run macros are instructions of
+// their own, carried out by machine.
+//
+using function_t = void (*)(ydc_stack&, const char);
+using fn_table = array<function_t, 256>;
+const fn_table do_functions = []() {
+   fn_table table {};
+   table['+'] = do_arith;
+   table['-'] = do_arith;
+   table['*'] = do_arith;
+   table['/'] = do_arith;
+   table['%'] = do_arith;
+   table['^'] = do_arith;
+   table['G'] = do_arith;
+   table['|'] = do_powmod;
+   table['~'] = do_divrem;
+   table['F'] = do_unary;
+   table['R'] = do_restore;
+   table['W'] = do_save;
+   table['Y'] = do_debug;
+   table['c'] = do_clear;
+   table['d'] = do_dup;
+   table['f'] = do_printall;
+   table['p'] = do_print;
+   table['v'] = do_unary;
+   return table;
+}();
+
+//
+// scanned_t
+//    A token translated into an instruction, with its number or macro
+//    already converted, so that it outlives the scanner's buffer and
+//    can be handed between threads.  With defer, a long number is
+//    kept as text until it is used, so one that is only printed is
+//    never converted; the pipeline instead converts on the scanner
+//    thread, where the work overlaps with evaluation.
+//
+
+struct scanned_t {
+   terminal_symbol symbol {SCANEOF};
+   instruction step {opcode::command, 0, 0};
+   bigint number;
+   shared_ptr<const program> macro;
+};
+
+scanned_t convert (const token_t& token, bool defer) {
+   scanned_t item;
+   item.symbol = token.symbol;
+   switch (token.symbol) {
+      case NUMBER:
+         item.number = defer ? bigint::deferred (token.lexinfo,
+                                                 token.length)
+                             : bigint (token.lexinfo, token.length);
+         break;
+      case STRING:
+         item.macro = compile (token.lexinfo, token.length);
+         break;
+      case OPERATOR:
+         item.step = translate (token);
+         break;
+      default:
+         break;
+   }
+   return item;
+}
+
+//
+// operand_digits
+//    Digits in the largest number the command will take from the
+//    stack, for the -s histogram, or 0 for a command that takes none.
+//
+
+size_t operand_digits (ydc_stack& stack, char oper) {
+   size_t operands = 0;
+   switch (oper) {
+      case 'F': case 'v': operands = 1; break;
+      case '|': operands = 3; break;
+      case '+': case '-': case '*': case '/': case '%': case '^':
+      case 'G': case '~': operands = 2; break;
+   }
+   size_t digits = 0;
+   for (const auto& value: stack) {
+      if (operands-- == 0) break;
+      if (not value.is_macro()) {
+         digits = max (digits, value.number.digits());
+      }
+   }
+   return digits;
+}
+
+//
+// machine
+//    Carries out instructions on the stack and the registers, each
+//    register being a stack of its own.  A running macro is a frame
+//    on an explicit stack, not a C++ call, and frames that have run
+//    to their end are dropped before a new one is pushed, so a macro
+//    that calls itself last loops in constant space.  As in dc, an
+//    error is reported and execution goes on with the next
+//    instruction; ydc_quit is left for main to catch.
+//
+
+class machine {
+   private:
+      struct frame {
+         shared_ptr<const program> code;
+         size_t next;
+      };
+      ydc_stack& stack;
+      array<ydc_stack, 256> registers;
+      vector<frame> frames;
+      ydc_stack& non_empty (unsigned char reg);
+      void call (const ydc_value& value);
+      void branch (const instruction& step);
+      void perform (const instruction& step, const program* code);
+      void attempt (const instruction& step, const program* code);
+      void run();
+   public:
+      explicit machine (ydc_stack& stack): stack (stack) {}
+      void execute (scanned_t& item);
 };
 
+ydc_stack& machine::non_empty (unsigned char reg) {
+   ydc_stack& values = registers[reg];
+   if (values.empty()) {
+      throw ydc_exn (string ("register ") + char (reg) + " is empty");
+   }
+   return values;
+}
+
+//
+// Run a macro, or push a number back, as x does.
+//
+void machine::call (const ydc_value& value) {
+   if (not value.is_macro()) {
+      stack.push (value);
+      return;
+   }
+   shared_ptr<const program> code = value.macro;
+   while (not frames.empty()
+          and frames.back().next == frames.back().code->code.size()) {
+      frames.pop_back();
+   }
+   frames.push_back (frame {move (code), 0});
+}
+
+void machine::branch (const instruction& step) {
+   need_numbers (stack, 2);
+   bigint top = pop_number (stack);
+   bigint second = pop_number (stack);
+   bool taken = false;
+   switch (step.op) {
+      case opcode::if_less:        taken = top < second; break;
+      case opcode::if_greater:     taken = top > second; break;
+      case opcode::if_equal:       taken = top == second; break;
+      case opcode::unless_less:    taken = not (top < second); break;
+      case opcode::unless_greater: taken = not (top > second); break;
+      case opcode::unless_equal:   taken = top != second; break;
+      default: break;
+   }
+   if (taken) call (non_empty (step.reg).top());
+}
+
+void machine::perform (const instruction& step, const program* code) {
+   switch (step.op) {
+      case opcode::number:
+         stack.push (ydc_value (code->numbers[step.index]));
+         break;
+      case opcode::macro:
+         stack.push (ydc_value (code->macros[step.index]));
+         break;
+      case opcode::command: {
+         function_t function = do_functions[step.reg];
+         if (function == nullptr) {
+            throw ydc_exn (octal (step.reg) + " is unimplemented");
+         }
+         if (not opstats::enabled()) {
+            function (stack, step.reg);
+            break;
+         }
+         opstats::sample sample (step.reg,
+                                 operand_digits (stack, step.reg));
+         function (stack, step.reg);
+         break;
+      }
+      case opcode::execute: {
+         if (stack.empty()) throw ydc_exn ("stack empty");
+         ydc_value value = move (stack.top());
+         stack.pop();
+         call (value);
+         break;
+      }
+      case opcode::store: {
+         if (stack.empty()) throw ydc_exn ("stack empty");
+         ydc_stack& values = registers[step.reg];
+         if (not values.empty()) values.pop();
+         values.push (move (stack.top()));
+         stack.pop();
+         break;
+      }
+      case opcode::load:
+         stack.push (non_empty (step.reg).top());
+         break;
+      case opcode::push_reg:
+         if (stack.empty()) throw ydc_exn ("stack empty");
+         registers[step.reg].push (move (stack.top()));
+         stack.pop();
+         break;
+      case opcode::pop_reg: {
+         ydc_stack& values = non_empty (step.reg);
+         stack.push (move (values.top()));
+         values.pop();
+         break;
+      }
+      case opcode::if_less:
+      case opcode::if_greater:
+      case opcode::if_equal:
+      case opcode::unless_less:
+      case opcode::unless_greater:
+      case opcode::unless_equal:
+         branch (step);
+         break;
+      case opcode::quit:
+         // Leaves this macro and the one that called it.
+         if (frames.size() <= 1) throw ydc_quit();
+         frames.resize (frames.size() - 2);
+         break;
+      case opcode::quit_levels: {
+         need_numbers (stack, 1);
+         bigint levels = pop_number (stack);
+         if (levels < bigint (1)) {
+            throw ydc_exn ("Q command requires a number >= 1");
+         }
+         if (levels > bigint (long (frames.size()))) {
+            frames.clear();
+         }else {
+            frames.resize (frames.size() - levels.to_long());
+         }
+         break;
+      }
+   }
+}
+
+void machine::attempt (const instruction& step, const program* code) {
+   try {
+      perform (step, code);
+   }catch (ydc_exn& exn) {
+      cout << exn.what() << endl;
+   }catch (domain_error& exn) {
+      cout << exn.what() << endl;
+   }catch (range_error& exn) {
+      cout << exn.what() << endl;
+   }
+}
+
+void machine::run() {
+   while (not frames.empty()) {
+      frame& current = frames.back();
+      const program* code = current.code.get();
+      if (current.next == code->code.size()) {
+         frames.pop_back();
+         continue;
+      }
+      const instruction& step = code->code[current.next++];
+      attempt (step, code);
+   }
+}
+
+void machine::execute (scanned_t& item) {
+   switch (item.symbol) {
+      case NUMBER:
+         stack.push (move (item.number));
+         break;
+      case STRING:
+         stack.push (move (item.macro));
+         break;
+      case OPERATOR:
+         attempt (item.step, nullptr);
+         run();
+         break;
+      default:
+         break;
+   }
+}
+
+//
+// run_script
+//    Scan and execute one script to its end.
+//
+
+void run_script (scanner& input, machine& ydc) {
+   for (;;) {
+      scanned_t item = convert (input.scan(), true);
+      if (item.symbol == SCANEOF) break;
+      ydc.execute (item);
+   }
+}
+
+//
+// run_pipelined
+//    As run_script, but a second thread scans and converts tokens
+//    into a queue while this one executes them, so that converting
+//    a long literal overlaps with arithmetic on the ones before it.
+//    On quit, the scanner thread stops at its next token, which for
+//    an interactive input means after the next line is read.
+//
+
+void run_pipelined (scanner& input, machine& ydc) {
+   spsc_queue<scanned_t> queue (6);
+   thread producer ([&input, &queue]() {
+      for (;;) {
+         scanned_t item = convert (input.scan(), false);
+         bool last = item.symbol == SCANEOF;
+         if (not queue.push (move (item)) or last) return;
+      }
+   });
+   try {
+      for (;;) {
+         scanned_t item;
+         queue.pop (item);
+         if (item.symbol == SCANEOF) break;
+         ydc.execute (item);
+      }
+   }catch (ydc_quit&) {
+      queue.cancel();
+      producer.join();
+      throw;
+   }
+   producer.join();
+}
+
+//
+// run
+//    Run one script in whichever mode the options asked for.
+//
+
+void run (scanner& input, machine& ydc) {
+   if (pipelined) {
+      run_pipelined (input, ydc);
+   }else {
+      run_script (input, ydc);
+   }
+}
+
+//
+// set_tuning
+//    Parse a list of name=value pairs separated by commas, as given
+//    to -T, into bigtuning.
+//
+
+void set_tuning (const string& settings) {
+   size_t begin = 0;
+   while (begin < settings.size()) {
+      size_t end = settings.find (',', begin);
+      if (end == string::npos) end = settings.size();
+      string setting = settings.substr (begin, end - begin);
+      size_t equals = setting.find ('=');
+      char* digits_end = nullptr;
+      const char* digits = equals == string::npos ? ""
+                         : setting.c_str() + equals + 1;
+      unsigned long value = strtoul (digits, &digits_end, 10);
+      if (*digits == '\0' or *digits_end != '\0'
+       or not bigtuning::set (setting.substr (0, equals), value)) {
+         complain() << "-T " << setting << ": invalid tuning" << endl;
+      }
+      begin = end + 1;
+   }
+}
 
 //
 // scan_options
-//    Options analysis:  The only option is -Dflags. 
+//    Options analysis:
+//    -@flags     turn on debug flags
+//    -c file     checkpoint file for W and R, default ydc.ckpt
+//    -j threads  multiply with up to this many threads
+//    -P          pipeline:  scan on one thread, evaluate on another
+//    -s format   report operator statistics at exit, as table or json
+//    -T name=n   set a bigtuning threshold:  karatsuba, toom3, ntt,
+//                bz (Burnikel-Ziegler division, at least 2), or
+//                parallel
+//    -w width    print numbers in lines of width characters, the
+//                last a backslash, as dc does; 0, the default, never
+//                breaks them
+//    Operands are script files, left for main.
 //
 
 void scan_options (int argc, char** argv) {
    if (sys_info::execname().size() == 0) sys_info::execname (argv[0]);
    opterr = 0;
    for (;;) {
-      int option = getopt (argc, argv, "@:");
+      int option = getopt (argc, argv, "@:c:j:Ps:T:w:");
       if (option == EOF) break;
       switch (option) {
          case '@':
             debugflags::setflags (optarg);
             break;
+         case 'c':
+            checkpoint_file = optarg;
+            break;
+         case 'j': {
+            char* digits_end = nullptr;
+            unsigned long threads = strtoul (optarg, &digits_end, 10);
+            if (*optarg == '\0' or *digits_end != '\0'
+             or threads == 0) {
+               complain() << "-j " << optarg << ": invalid thread count"
+                          << endl;
+            }else {
+               bigtuning::threads = threads;
+            }
+            break;
+            }
+         case 'P':
+            pipelined = true;
+            break;
+         case 's':
+            if (not opstats::setformat (optarg)) {
+               complain() << "-s " << optarg << ": invalid format"
+                          << endl;
+            }
+            break;
+         case 'T':
+            set_tuning (optarg);
+            break;
+         case 'w': {
+            char* digits_end = nullptr;
+            unsigned long width = strtoul (optarg, &digits_end, 10);
+            if (*optarg == '\0' or *digits_end != '\0' or width == 1) {
+               complain() << "-w " << optarg << ": invalid line width"
+                          << endl;
+            }else {
+               line_width = width;
+            }
+            break;
+            }
          default:
             complain() << "-" << (char) optopt << ": invalid option"
                        << endl;
             break;
       }
    }
-   if (optind < argc) {
-      complain() << "operand not permitted" << endl;
-   }
 }
 
 //
 // Main function.
+//    Each operand names a script file, run in order on one stack,
+//    with - meaning the standard input.  With no operands, the
+//    standard input is run.
 //
 
 int main (int argc, char** argv) {
    sys_info::execname (argv[0]);
    scan_options (argc, argv);
-   bigint_stack operand_stack;
-   scanner input;
+   ydc_stack operand_stack;
+   machine ydc (operand_stack);
    try {
-      for (;;) {
-         try {
-            token_t token = input.scan();
-            if (token.symbol == SCANEOF) break;
-            switch (token.symbol) {
-               case NUMBER:
-                  operand_stack.push (token.lexinfo);
-                  break;
-               case OPERATOR: {
-                  fn_map::const_iterator fn
-                           = do_functions.find (token.lexinfo);
-                  if (fn == do_functions.end()) {
-                     throw ydc_exn (octal (token.lexinfo[0])
-                                    + " is unimplemented");
-                  }
-                  fn->second (operand_stack, token.lexinfo.at(0));
-                  break;
-                  }
-               default:
-                  break;
-            }
-         }catch (ydc_exn& exn) {
-            cout << exn.what() << endl;
+      if (optind == argc) {
+         scanner input;
+         run (input, ydc);
+      }
+      for (int argi = optind; argi < argc; ++argi) {
+         if (string (argv[argi]) == "-") {
+            scanner input;
+            run (input, ydc);
+            continue;
          }
+         mapped_file script (argv[argi]);
+         if (not script.is_open()) continue;
+         if (script.descriptor() >= 0) {
+            scanner input (script.descriptor());
+            run (input, ydc);
+            continue;
+         }
+         scanner input (script.data(), script.size());
+         run (input, ydc);
       }
    }catch (ydc_quit&) {
       // Intentionally left empty.
    }
+   opstats::report (cerr);
    return sys_info::status();
 }
-
@@ -0,0 +1,80 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+#include <iostream>
+using namespace std;
+
+#include "program.h"
+#include "debug.h"
+
+instruction translate (const token_t& token) {
+   instruction result {opcode::command, 0, 0};
+   const char* text = token.lexinfo;
+   size_t length = token.length;
+   bool unless = length == 3 and text[0] == '!';
+   if (unless) {
+      ++text;
+      --length;
+   }
+   result.reg = text[0];
+   if (length < 2) {
+      switch (text[0]) {
+         case 'x': result.op = opcode::execute; break;
+         case 'q': result.op = opcode::quit; break;
+         case 'Q': result.op = opcode::quit_levels; break;
+      }
+      return result;
+   }
+   result.reg = text[1];
+   switch (text[0]) {
+      case 's': result.op = opcode::store; break;
+      case 'l': result.op = opcode::load; break;
+      case 'S': result.op = opcode::push_reg; break;
+      case 'L': result.op = opcode::pop_reg; break;
+      case '<': result.op = unless ? opcode::unless_less
+                                   : opcode::if_less; break;
+      case '>': result.op = unless ? opcode::unless_greater
+                                   : opcode::if_greater; break;
+      case '=': result.op = unless ? opcode::unless_equal
+                                   : opcode::if_equal; break;
+      default: result.reg = text[0]; break;
+   }
+   return result;
+}
+
+shared_ptr<const program> compile (const char* text, size_t length) {
+   shared_ptr<program> result = make_shared<program>();
+   result->text.assign (text, length);
+   scanner input (result->text.data(), result->text.size());
+   for (;;) {
+      token_t token = input.scan();
+      if (token.symbol == SCANEOF) break;
+      instruction step {opcode::command, 0, 0};
+      switch (token.symbol) {
+         case NUMBER:
+            step.op = opcode::number;
+            step.index = result->numbers.size();
+            result->numbers.emplace_back (token.lexinfo, token.length);
+            break;
+         case STRING:
+            step.op = opcode::macro;
+            step.index = result->macros.size();
+            result->macros.push_back (compile (token.lexinfo,
+                                               token.length));
+            break;
+         default:
+            step = translate (token);
+            break;
+      }
+      result->code.push_back (step);
+   }
+   DEBUGF ('b', "compiled " << result->code.size()
+                << " instructions from [" << result->text << "]");
+   return result;
+}
+
+ostream& operator<< (ostream& out, const ydc_value& value) {
+   if (value.is_macro()) return out << value.macro->text;
+   return out << value.number;
+}
+
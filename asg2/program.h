@@ -0,0 +1,91 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// program -
+//    A macro compiled once, when its [string] is scanned, into an
+//    array of instructions.  Running a macro then needs no scanning
+//    and no lookup by name:  numbers and nested macros are indices
+//    into tables of constants, register commands carry the register
+//    as a byte, and every other command is its own character, which
+//    indexes a table of functions.
+//
+
+#ifndef __PROGRAM_H__
+#define __PROGRAM_H__
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "bigint.h"
+#include "iterstack.h"
+#include "scanner.h"
+
+enum class opcode: uint8_t {
+   number,      // push numbers[index]
+   macro,       // push macros[index]
+   command,     // run the command named by reg
+   execute,     // x
+   store,       // s reg
+   load,        // l reg
+   push_reg,    // S reg
+   pop_reg,     // L reg
+   if_less,     // < reg
+   if_greater,  // > reg
+   if_equal,    // = reg
+   unless_less, // !< reg
+   unless_greater, // !> reg
+   unless_equal,   // != reg
+   quit,        // q
+   quit_levels, // Q
+};
+
+struct instruction {
+   opcode op;
+   unsigned char reg;
+   uint32_t index;
+};
+
+struct program;
+
+//
+// ydc_value -
+//    What the stack and the registers hold:  a macro if macro is set,
+//    otherwise a number.
+//
+struct ydc_value {
+   bigint number;
+   shared_ptr<const program> macro;
+   ydc_value() = default;
+   ydc_value (bigint number): number (move (number)) {}
+   ydc_value (shared_ptr<const program> macro): macro (move (macro)) {}
+   bool is_macro() const { return macro != nullptr; }
+};
+
+using ydc_stack = iterstack<ydc_value>;
+
+struct program {
+   string text;
+   vector<instruction> code;
+   vector<bigint> numbers;
+   vector<shared_ptr<const program>> macros;
+};
+
+//
+// Compile the text of a macro, and any macros nested in it.
+//
+shared_ptr<const program> compile (const char* text, size_t length);
+
+//
+// The instruction for an OPERATOR token.
+//
+instruction translate (const token_t& token);
+
+ostream& operator<< (ostream&, const ydc_value&);
+
+#endif
+
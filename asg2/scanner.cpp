@@ -1,41 +1,111 @@
 //Brandon Jarvinen (bjarvine@ucsc.edu)
 //Fan Zhang (fzhang12@ucsc.edu)
 
+#include <cctype>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
-#include <locale>
 using namespace std;
 
+#include <unistd.h>
+
 #include "scanner.h"
 #include "debug.h"
+#include "util.h"
 
-scanner::scanner() {
+scanner::scanner (int fd): fd(fd), buffer (1 << 16) {
+   next = limit = buffer.data();
    seen_eof = false;
-   advance();
 }
 
-void scanner::advance() {
-   if (not seen_eof) {
-      cin.get (lookahead);
-      if (cin.eof()) seen_eof = true;
+scanner::scanner (const char* text, size_t length): fd(-1) {
+   next = text;
+   limit = text + length;
+   seen_eof = true;
+}
+
+//
+// Keep [start, limit) at the front of the buffer and read more after
+// it.  start and next are moved along with the text.  Returns false
+// once the input is exhausted.
+//
+bool scanner::refill (const char*& start) {
+   if (seen_eof) return false;
+   size_t begin = start - buffer.data();
+   size_t offset = next - start;
+   size_t kept = limit - start;
+   if (kept * 2 > buffer.size()) buffer.resize (buffer.size() * 2);
+   memmove (buffer.data(), buffer.data() + begin, kept);
+   ssize_t got;
+   do {
+      got = read (fd, buffer.data() + kept, buffer.size() - kept);
+   }while (got < 0 and errno == EINTR);
+   if (got < 0) {
+      complain() << "read: " << strerror (errno) << endl;
+      got = 0;
+   }
+   if (got == 0) seen_eof = true;
+   start = buffer.data();
+   next = start + offset;
+   limit = start + kept + got;
+   return got > 0;
+}
+
+static bool one_of (char symbol, const char* symbols) {
+   return symbol != '\0' and strchr (symbols, symbol) != nullptr;
+}
+
+//
+// True if there is a character at next, reading more if needed.
+//
+bool scanner::more (const char*& start) {
+   return next < limit or refill (start);
+}
+
+void scanner::skip_blanks() {
+   while (more (next)) {
+      if (*next == '#') {
+         while (more (next) and *next != '\n') ++next;
+      }else if (isspace ((unsigned char) *next)) {
+         ++next;
+      }else {
+         break;
+      }
    }
 }
 
 token_t scanner::scan() {
    token_t result;
-   while (not seen_eof and isspace (lookahead)) advance();
-   if (seen_eof) {
+   skip_blanks();
+   const char* start = next;
+   if (not more (start)) {
       result.symbol = SCANEOF;
-   }else if (lookahead == '_' or isdigit (lookahead)) {
+   }else if (*next == '_' or isdigit ((unsigned char) *next)) {
       result.symbol = NUMBER;
-      do {
-         result.lexinfo += lookahead;
-         advance();
-      }while (not seen_eof and isdigit (lookahead));
+      ++next;
+      while (more (start) and isdigit ((unsigned char) *next)) ++next;
+   }else if (*next == '[') {
+      result.symbol = STRING;
+      size_t depth = 1;
+      for (++next; more (start); ++next) {
+         if (*next == '[') ++depth;
+         else if (*next == ']' and --depth == 0) break;
+      }
+      result.lexinfo = start + 1;
+      result.length = next - start - 1;
+      if (next < limit) ++next;
+      DEBUGF ('S', result);
+      return result;
    }else {
       result.symbol = OPERATOR;
-      result.lexinfo += lookahead;
-      advance();
+      char oper = *next++;
+      if (oper == '!' and more (start) and one_of (*next, "<>=")) {
+         oper = *next++;
+      }
+      if (one_of (oper, "sSlL<>=") and more (start)) ++next;
    }
+   result.lexinfo = start;
+   result.length = next - start;
    DEBUGF ('S', result);
    return result;
 }
@@ -44,13 +114,16 @@ ostream& operator<< (ostream& out, const terminal_symbol& symbol) {
    switch (symbol) {
       case NUMBER  : out << "NUMBER"  ; break;
       case OPERATOR: out << "OPERATOR"; break;
+      case STRING  : out << "STRING"  ; break;
       case SCANEOF : out << "SCANEOF" ; break;
    }
    return out;
 }
 
 ostream& operator<< (ostream& out, const token_t& token) {
-   out << token.symbol << ": \"" << token.lexinfo << "\"";
+   out << token.symbol << ": \"";
+   out.write (token.lexinfo, token.length);
+   out << "\"";
    return out;
 }
 
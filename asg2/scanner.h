@@ -6,23 +6,48 @@
 
 #include <iostream>
 #include <utility>
+#include <vector>
 using namespace std;
 
 #include "debug.h"
 
-enum terminal_symbol {NUMBER, OPERATOR, SCANEOF};
+enum terminal_symbol {NUMBER, OPERATOR, STRING, SCANEOF};
+
+//
+// A token's text is a view into the scanner's buffer.  It stays
+// valid only until the next call to scan.  A STRING is the text
+// between matching brackets, without them.  An OPERATOR is one
+// character, except that a register command (s, S, l, L, <, >, =,
+// and !<, !>, !=) also takes the character after it, whatever it
+// is, as the register name.  A # starts a comment to end of line.
+//
 struct token_t {
    terminal_symbol symbol;
-   string lexinfo;
+   const char* lexinfo;
+   size_t length;
 };
 
+//
+// The scanner reads its file descriptor a block at a time.  A token
+// that runs off the end of the buffer is moved to the front and the
+// rest read in after it, doubling the buffer if the token fills more
+// than half of it, so a literal of any length ends up contiguous.
+// Given text already in memory, such as a mapped file, the scanner
+// hands out views into that text and never copies it.
+//
 class scanner {
    private:
+      int fd;
+      vector<char> buffer;
+      const char* next;
+      const char* limit;
       bool seen_eof;
-      char lookahead;
-      void advance();
+      bool refill (const char*& start);
+      bool more (const char*& start);
+      void skip_blanks();
    public:
-      scanner();
+      scanner (int fd = 0);
+      scanner (const char* text, size_t length);
       token_t scan();
 };
 
@@ -0,0 +1,144 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// A bounded queue for exactly one producer thread and one consumer
+// thread.  The items live in a ring whose size is a power of two.
+// Only the producer advances tail and only the consumer advances
+// head, so each side needs one acquire load of the other's index
+// and one release store of its own, and never a lock.
+//
+// try_push and try_pop fail rather than wait.  push and pop yield a
+// few times, then sleep on a condition variable until the other side
+// makes room or adds an item, so a busy pipeline rarely sleeps and
+// an idle one costs no CPU.  The mutex is taken only
+// when a thread goes to sleep or finds the other one asleep:  each
+// side counts itself into sleepers before its last look at the
+// ring, and each store of an index is followed by a look at
+// sleepers, with a full fence between on both sides, so at least
+// one of the two looks sees the other's write.  cancel, from the
+// consumer, makes the producer's push give up.
+//
+
+#ifndef __SPSCQUEUE_H__
+#define __SPSCQUEUE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+template <typename item_t>
+class spsc_queue {
+   private:
+      vector<item_t> ring;
+      size_t mask;
+      alignas(64) atomic<size_t> head {0};
+      alignas(64) atomic<size_t> tail {0};
+      atomic<int> sleepers {0};
+      atomic<bool> cancelled {false};
+      mutex lock;
+      condition_variable changed;
+      static const int spin_limit = 64;
+
+      bool full() const {
+         return tail.load (memory_order_relaxed)
+              - head.load (memory_order_acquire) == ring.size();
+      }
+      bool empty() const {
+         return head.load (memory_order_relaxed)
+             == tail.load (memory_order_acquire);
+      }
+      void wake() {
+         atomic_thread_fence (memory_order_seq_cst);
+         if (sleepers.load (memory_order_relaxed) == 0) return;
+         lock_guard<mutex> guard (lock);
+         changed.notify_all();
+      }
+      template <typename ready_t>
+      void sleep_until (ready_t ready) {
+         for (int spin = 0; spin < spin_limit; ++spin) {
+            if (ready()) return;
+            this_thread::yield();
+         }
+         unique_lock<mutex> guard (lock);
+         sleepers.fetch_add (1);
+         atomic_thread_fence (memory_order_seq_cst);
+         changed.wait (guard, ready);
+         sleepers.fetch_sub (1);
+      }
+   public:
+      explicit spsc_queue (size_t capacity_log2):
+               ring (size_t (1) << capacity_log2),
+               mask (ring.size() - 1) {}
+      spsc_queue (const spsc_queue&) = delete;
+      spsc_queue& operator= (const spsc_queue&) = delete;
+
+      //
+      // Producer only.  Moves item in unless the ring is full.
+      //
+      bool try_push (item_t&& item) {
+         size_t back = tail.load (memory_order_relaxed);
+         if (back - head.load (memory_order_acquire) == ring.size()) {
+            return false;
+         }
+         ring[back & mask] = move (item);
+         tail.store (back + 1, memory_order_release);
+         wake();
+         return true;
+      }
+
+      //
+      // Consumer only.  Moves the oldest item out unless the ring is
+      // empty.
+      //
+      bool try_pop (item_t& item) {
+         size_t front = head.load (memory_order_relaxed);
+         if (front == tail.load (memory_order_acquire)) return false;
+         item = move (ring[front & mask]);
+         head.store (front + 1, memory_order_release);
+         wake();
+         return true;
+      }
+
+      //
+      // Producer only.  Moves item in, waiting while the ring is
+      // full.  Returns false without taking item once the consumer
+      // has cancelled.
+      //
+      bool push (item_t&& item) {
+         for (;;) {
+            if (cancelled.load()) return false;
+            if (try_push (move (item))) return true;
+            sleep_until ([this]() {
+               return not full() or cancelled.load();
+            });
+         }
+      }
+
+      //
+      // Consumer only.  Moves the oldest item out, waiting while the
+      // ring is empty.
+      //
+      void pop (item_t& item) {
+         while (not try_pop (item)) {
+            sleep_until ([this]() { return not empty(); });
+         }
+      }
+
+      //
+      // Consumer only.  Makes every later push fail, and wakes the
+      // producer if it is waiting in one.
+      //
+      void cancel() {
+         cancelled.store (true);
+         lock_guard<mutex> guard (lock);
+         changed.notify_all();
+      }
+};
+
+#endif
+
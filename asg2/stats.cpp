@@ -0,0 +1,151 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+using namespace std;
+
+#include "limbs.h"
+#include "stats.h"
+
+using steady = chrono::steady_clock;
+
+opstats::format opstats::format_ = opstats::format::none;
+steady::time_point opstats::start;
+array<opstats::counters, 256> opstats::table;
+
+//
+// The allocation counters.  With statistics off, operator new costs
+// one extra test.
+//
+static atomic<uint64_t> bytes_allocated {0};
+static atomic<uint64_t> allocation_count {0};
+
+void* operator new (size_t size) {
+   if (opstats::enabled()) {
+      bytes_allocated.fetch_add (size, memory_order_relaxed);
+      allocation_count.fetch_add (1, memory_order_relaxed);
+   }
+   void* result = malloc (size == 0 ? 1 : size);
+   if (result == nullptr) throw bad_alloc();
+   return result;
+}
+
+void* operator new[] (size_t size) {
+   return operator new (size);
+}
+
+void operator delete (void* pointer) noexcept {
+   free (pointer);
+}
+
+void operator delete[] (void* pointer) noexcept {
+   free (pointer);
+}
+
+bool opstats::setformat (const string& name) {
+   if (name == "table") format_ = format::table;
+   else if (name == "json") format_ = format::json;
+   else return false;
+   start = steady::now();
+   return true;
+}
+
+uint64_t opstats::allocated_bytes() {
+   return bytes_allocated.load (memory_order_relaxed);
+}
+
+uint64_t opstats::allocations() {
+   return allocation_count.load (memory_order_relaxed);
+}
+
+opstats::sample::sample (char oper, size_t digits):
+               oper (oper), digits (digits), start (steady::now()),
+               allocated (allocated_bytes()) {
+   limb_scratch::reset_peak();
+}
+
+opstats::sample::~sample() {
+   counters& entry = table[oper];
+   ++entry.calls;
+   entry.time += steady::now() - start;
+   entry.allocated += allocated_bytes() - allocated;
+   entry.scratch_peak = max (entry.scratch_peak,
+                             limb_scratch::peak_bytes());
+   size_t decade = 0;
+   for (size_t size = digits; size >= 10 and decade + 1 < decades;
+        size /= 10) {
+      ++decade;
+   }
+   if (digits > 0) ++entry.digits[decade];
+}
+
+static double seconds (chrono::nanoseconds time) {
+   return chrono::duration<double> (time).count();
+}
+
+//
+// Decade d of the histogram holds operands of 10^d to 10^(d+1) - 1
+// digits, labeled by its lower bound.
+//
+static string decade_label (size_t decade) {
+   return "1" + string (decade, '0');
+}
+
+void opstats::report (ostream& out) {
+   if (not enabled()) return;
+   double wall = seconds (steady::now() - start);
+   if (format_ == format::json) {
+      out << "{\"wall_seconds\": " << wall
+          << ", \"allocated_bytes\": " << allocated_bytes()
+          << ", \"allocations\": " << allocations()
+          << ", \"operators\": {";
+      string comma = "";
+      for (size_t oper = 0; oper < table.size(); ++oper) {
+         const counters& entry = table[oper];
+         if (entry.calls == 0) continue;
+         out << comma << "\"";
+         if (oper == '"' or oper == '\\') out << '\\';
+         out << char (oper) << "\": {\"calls\": " << entry.calls
+             << ", \"seconds\": " << seconds (entry.time)
+             << ", \"allocated_bytes\": " << entry.allocated
+             << ", \"scratch_peak_bytes\": " << entry.scratch_peak
+             << ", \"digits\": {";
+         string inner = "";
+         for (size_t decade = 0; decade < decades; ++decade) {
+            if (entry.digits[decade] == 0) continue;
+            out << inner << "\"" << decade_label (decade) << "\": "
+                << entry.digits[decade];
+            inner = ", ";
+         }
+         out << "}}";
+         comma = ", ";
+      }
+      out << "}}" << endl;
+      return;
+   }
+   out << "wall time " << wall << " s, " << allocated_bytes()
+       << " bytes in " << allocations() << " allocations" << endl;
+   out << "op" << setw (12) << "calls" << setw (14) << "seconds"
+       << setw (16) << "alloc bytes" << setw (16) << "scratch peak"
+       << "  operand digits" << endl;
+   for (size_t oper = 0; oper < table.size(); ++oper) {
+      const counters& entry = table[oper];
+      if (entry.calls == 0) continue;
+      out << char (oper) << " " << setw (12) << entry.calls
+          << setw (14) << fixed << setprecision (6)
+          << seconds (entry.time) << setw (16) << entry.allocated
+          << setw (16) << entry.scratch_peak;
+      out.unsetf (ios::floatfield);
+      for (size_t decade = 0; decade < decades; ++decade) {
+         if (entry.digits[decade] == 0) continue;
+         out << "  " << decade_label (decade) << ":"
+             << entry.digits[decade];
+      }
+      out << endl;
+   }
+}
+
@@ -0,0 +1,68 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+using namespace std;
+
+//
+// opstats -
+//    static class for the -s statistics mode.  For each command it
+//    keeps the number of calls, the time spent, the bytes allocated
+//    while it ran, the most limb scratch it held at once, and a
+//    histogram of operand sizes by decade of decimal digits.
+//    Allocation is counted by replacing the global operator new, and
+//    counts every thread, so -j workers count toward the command
+//    that started them; so does a -P scanner thread running at the
+//    same time.
+// setformat -
+//    Takes "table" or "json" and turns collection on.  Returns false
+//    for any other format.
+// sample -
+//    Created around one command; records it when destroyed, whether
+//    the command returned or threw.
+// report -
+//    Writes everything collected, in the chosen format.
+//
+
+class opstats {
+   public:
+      enum class format {none, table, json};
+      static const size_t decades = 20;
+      struct counters {
+         uint64_t calls {0};
+         chrono::nanoseconds time {0};
+         uint64_t allocated {0};
+         size_t scratch_peak {0};
+         array<uint64_t, decades> digits {};
+      };
+      class sample {
+         private:
+            unsigned char oper;
+            size_t digits;
+            chrono::steady_clock::time_point start;
+            uint64_t allocated;
+         public:
+            sample (char oper, size_t digits);
+            ~sample();
+      };
+   private:
+      static format format_;
+      static chrono::steady_clock::time_point start;
+      static array<counters, 256> table;
+   public:
+      static bool setformat (const string& name);
+      static bool enabled() {return format_ != format::none; }
+      static uint64_t allocated_bytes();
+      static uint64_t allocations();
+      static void report (ostream& out);
+};
+
+#endif
+
@@ -0,0 +1,143 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "limbs.h"
+#include "taskpool.h"
+
+//
+// The pool is a single deque under one lock.  Tasks in the kernels
+// are large, so contention on the lock is not worth engineering
+// away.
+//
+class task_pool {
+   private:
+      struct entry {
+         task_group* group;
+         function<void()> task;
+      };
+      mutex lock;
+      condition_variable ready;
+      deque<entry> queue;
+      vector<thread> workers;
+      bool stopping {false};
+      void work();
+      static void execute (entry& job);
+   public:
+      ~task_pool();
+      void submit (task_group* group, function<void()>&& task);
+      bool help();
+      static task_pool& instance();
+};
+
+task_pool& task_pool::instance() {
+   static task_pool pool;
+   return pool;
+}
+
+task_pool::~task_pool() {
+   {
+      lock_guard<mutex> guard (lock);
+      stopping = true;
+   }
+   ready.notify_all();
+   for (auto& worker: workers) worker.join();
+}
+
+void task_pool::execute (entry& job) {
+   exception_ptr error;
+   try {
+      job.task();
+   }catch (...) {
+      error = current_exception();
+   }
+   job.group->finish (error);
+}
+
+void task_pool::work() {
+   for (;;) {
+      entry job;
+      {
+         unique_lock<mutex> guard (lock);
+         ready.wait (guard, [this]() {
+            return stopping or not queue.empty();
+         });
+         if (queue.empty()) return;
+         job = move (queue.front());
+         queue.pop_front();
+      }
+      execute (job);
+   }
+}
+
+void task_pool::submit (task_group* group, function<void()>&& task) {
+   {
+      lock_guard<mutex> guard (lock);
+      while (workers.size() + 1 < bigtuning::threads) {
+         workers.emplace_back (&task_pool::work, this);
+      }
+      queue.push_back (entry {group, move (task)});
+   }
+   ready.notify_one();
+}
+
+//
+// Run the newest queued task, if there is one, on this thread.
+//
+bool task_pool::help() {
+   entry job;
+   {
+      lock_guard<mutex> guard (lock);
+      if (queue.empty()) return false;
+      job = move (queue.back());
+      queue.pop_back();
+   }
+   execute (job);
+   return true;
+}
+
+task_group::task_group (bool parallel): parallel (parallel) {
+}
+
+void task_group::finish (exception_ptr error) {
+   if (error) {
+      lock_guard<mutex> guard (failure_lock);
+      if (not failure) failure = error;
+   }
+   pending.fetch_sub (1, memory_order_release);
+}
+
+void task_group::run (function<void()> task) {
+   if (not parallel or bigtuning::threads <= 1) {
+      task();
+      return;
+   }
+   pending.fetch_add (1, memory_order_relaxed);
+   try {
+      task_pool::instance().submit (this, move (task));
+   }catch (...) {
+      pending.fetch_sub (1, memory_order_relaxed);
+      throw;
+   }
+}
+
+task_group::~task_group() {
+   drain();
+}
+
+void task_group::drain() {
+   while (pending.load (memory_order_acquire) > 0) {
+      if (not task_pool::instance().help()) this_thread::yield();
+   }
+}
+
+void task_group::wait() {
+   drain();
+   if (failure) rethrow_exception (failure);
+}
+
@@ -0,0 +1,62 @@
+//Brandon Jarvinen (bjarvine@ucsc.edu)
+//Fan Zhang (fzhang12@ucsc.edu)
+
+//
+// task_group -
+//    Fork and join for the multiplication kernels.  Tasks go to one
+//    shared pool of bigtuning::threads - 1 worker threads, started
+//    the first time they are needed.  A thread blocked in wait runs
+//    queued tasks itself, newest first, until its own group is done,
+//    so a task may fork a group of its own without tying up the
+//    pool.  Idle workers take the oldest, and usually largest, task.
+//
+//    A group made with parallel false, or any group when only one
+//    thread is configured, runs each task at once on the caller's
+//    thread, so serial callers pay nothing but the closure.
+//
+
+#ifndef __TASKPOOL_H__
+#define __TASKPOOL_H__
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+using namespace std;
+
+class task_group {
+   friend class task_pool;
+   private:
+      bool parallel;
+      atomic<size_t> pending {0};
+      mutex failure_lock;
+      exception_ptr failure;
+      void finish (exception_ptr error);
+      void drain();
+   public:
+      explicit task_group (bool parallel = true);
+      task_group (const task_group&) = delete;
+      task_group& operator= (const task_group&) = delete;
+
+      //
+      // Waits as wait does, but drops any exception, so that no task
+      // outlives the group or what it refers to, even when the
+      // caller leaves by an exception before calling wait.
+      //
+      ~task_group();
+
+      //
+      // Queue a task.  Everything it refers to must outlive the
+      // group.
+      //
+      void run (function<void()> task);
+
+      //
+      // Wait for every task run in this group, then rethrow the
+      // first exception any of them threw.
+      //
+      void wait();
+};
+
+#endif
+
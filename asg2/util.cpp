@@ -1,10 +1,17 @@
 //Brandon Jarvinen (bjarvine@ucsc.edu)
 //Fan Zhang (fzhang12@ucsc.edu)- $
 
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 using namespace std;
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "util.h"
 
 ydc_exn::ydc_exn (const string& what): runtime_error (what) {
@@ -33,3 +40,38 @@ ostream& complain() {
    return cerr;
 }
 
+mapped_file::mapped_file (const string& filename) {
+   int fd = ::open (filename.c_str(), O_RDONLY);
+   struct stat info;
+   if (fd < 0 or fstat (fd, &info) < 0) {
+      complain() << filename << ": " << strerror (errno) << endl;
+      if (fd >= 0) close (fd);
+      return;
+   }
+   open = true;
+   if (not S_ISREG (info.st_mode)) {
+      descriptor_ = fd;
+      return;
+   }
+   length = info.st_size;
+   if (length > 0) {
+      void* mapping = mmap (nullptr, length, PROT_READ, MAP_PRIVATE,
+                            fd, 0);
+      if (mapping == MAP_FAILED) {
+         complain() << filename << ": " << strerror (errno) << endl;
+         close (fd);
+         length = 0;
+         open = false;
+         return;
+      }
+      madvise (mapping, length, MADV_SEQUENTIAL);
+      text = static_cast<const char*> (mapping);
+   }
+   close (fd);
+}
+
+mapped_file::~mapped_file() {
+   if (text != nullptr) munmap (const_cast<char*> (text), length);
+   if (descriptor_ >= 0) close (descriptor_);
+}
+
@@ -64,6 +64,33 @@ class sys_info {
 
 ostream& complain();
 
+//
+// mapped_file -
+//    A file mapped read-only into memory for as long as the object
+//    lives.  If the file can not be opened or mapped, complains and
+//    leaves is_open false.  A file that is not a regular file, such
+//    as a pipe, can not be mapped; it is left open instead, and
+//    descriptor returns its file descriptor to be read, or -1 for a
+//    mapped file.
+//
+
+class mapped_file {
+   private:
+      const char* text {nullptr};
+      size_t length {0};
+      bool open {false};
+      int descriptor_ {-1};
+   public:
+      explicit mapped_file (const string& filename);
+      ~mapped_file();
+      mapped_file (const mapped_file&) = delete;
+      mapped_file& operator= (const mapped_file&) = delete;
+      bool is_open() const {return open; }
+      const char* data() const {return text; }
+      size_t size() const {return length; }
+      int descriptor() const {return descriptor_; }
+};
+
 //
 // operator<< (vector) -
 //    An overloaded template operator which allows vectors to be